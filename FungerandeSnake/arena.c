@@ -0,0 +1,280 @@
+/* arena.c
+
+   Several snakes on one board, see arena.h.
+
+   A move is two passes over the snakes. The first one finds where each
+   head goes and what is there: a wall, a body (the owner map says
+   whose) or a head that already claimed the cell this move. The second
+   one moves the survivors, with the same addHead and removeTail as the
+   single player game. Both look at one cell per snake, so a move costs
+   the same however long the snakes are. */
+
+#include "arena.h"
+#include "score.h"
+
+static const int step_row[4] = {-1, 0, 1, 0}; // north, east, south, west
+static const int step_col[4] = {0, 1, 0, -1};
+
+/* Stamps are 24 bits, the low byte of a claim is the id */
+static unsigned int next_stamp(Arena *arena)
+{
+    arena->stamp = (arena->stamp + 1) & 0xFFFFFF;
+    if (arena->stamp == 0) { // wrapped, so old claims could match again
+        for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+            arena->claim[i] = 0;
+        }
+        arena->stamp = 1;
+    }
+    return arena->stamp;
+}
+
+static inline bool claimed(const Arena *arena, int cell)
+{
+    return (arena->claim[cell] >> 8) == arena->stamp;
+}
+
+static inline int distance(int a, int b)
+{
+    return a < b ? b - a : a - b;
+}
+
+/* Inside the board with no body on it and no head moving into it yet */
+static bool open_cell(const Arena *arena, const Board *board, int row, int col)
+{
+    return (unsigned) row < BOARD_SIZE && (unsigned) col < BOARD_SIZE
+        && !board_is_snake(board, row, col) && !claimed(arena, CELL_INDEX(row, col));
+}
+
+/**
+ * @arg arena, the game
+ * @arg board, the board of the game
+ * @arg snake, a snake the game steers
+ * Turns towards the nearest fruit, away from cells that are taken and
+ * from cells with no way out. It looks at the few fruits and the three
+ * cells next to the head, so it costs the same every move
+ */
+static void steer(const Arena *arena, const Board *board, Snake *snake)
+{
+    Position head = snake->head;
+    int target = -1;
+    int nearest = 2 * BOARD_SIZE;
+    for (int i = 0; i < arena->fruit_count; i++) {
+        int cell = arena->fruits[i];
+        int d = distance(head.row, cell / BOARD_SIZE) + distance(head.col, cell % BOARD_SIZE);
+        if (d < nearest) {
+            nearest = d;
+            target = cell;
+        }
+    }
+
+    int best_direction = snake->direction; // straight into something if nothing is open
+    int best = -1;
+    for (int turn = 0; turn < 3; turn++) { // straight, right, left
+        int direction = (snake->direction + (turn == 2 ? 3 : turn)) & 3;
+        int row = head.row + step_row[direction];
+        int col = head.col + step_col[direction];
+        if (!open_cell(arena, board, row, col)) {
+            continue;
+        }
+        int exits = 0;
+        for (int d = 0; d < 4; d++) {
+            exits += open_cell(arena, board, row + step_row[d], col + step_col[d]);
+        }
+        int score = target < 0 ? turn
+            : distance(row, target / BOARD_SIZE) + distance(col, target % BOARD_SIZE);
+        if (exits == 0) {
+            score += 4 * BOARD_SIZE; // a dead end, only when nothing else is open
+        }
+        if (best < 0 || score < best) {
+            best = score;
+            best_direction = direction;
+        }
+    }
+    snake->direction = best_direction;
+}
+
+/**
+ * @arg arena, the game
+ * @arg id, the snake that dies
+ * @arg by, the snake it ran into, -1 for a wall or a head on collision
+ */
+static void kill_snake(Arena *arena, int id, int by)
+{
+    if (!arena->snakes[id].snake_playing) {
+        return;
+    }
+    arena->snakes[id].snake_playing = false;
+    arena->died[id] = arena->moves;
+    if (by >= 0 && by != id) {
+        arena->kills[by]++;
+    }
+}
+
+static void remove_fruit(Arena *arena, int cell)
+{
+    for (int i = 0; i < arena->fruit_count; i++) {
+        if (arena->fruits[i] == cell) {
+            arena->fruit_count--;
+            arena->fruits[i] = arena->fruits[arena->fruit_count];
+            return;
+        }
+    }
+}
+
+/**
+ * @arg arena, the game, zeroed before the first game (it is static)
+ * @arg board, the board of the game
+ * Puts every snake on a row of its own, players first, every other one
+ * starting from the right edge, and spreads FRUIT_COUNT fruits
+ */
+void arena_start(Arena *arena, Board *board)
+{
+    board_clear(board);
+    free_cells_init(&free_cells);
+    arena->moves = 0;
+    for (int id = 0; id < ARENA_SNAKES; id++) {
+        Snake *snake = &arena->snakes[id];
+        int row = (id + 1) * BOARD_SIZE / (ARENA_SNAKES + 1);
+        bool east = (id & 1) == 0;
+        int col = east ? 1 : BOARD_SIZE - 2;
+        snake_lay(snake, (Position){row, col}, east ? 1 : 3, ARENA_START_LENGTH);
+        snake->snake_playing = true;
+        snake->right = false;
+        snake->left = false;
+        snake->direction = east ? 1 : 3;
+        snake->id = id;
+        for (SnakeIter it = snake_iter(snake); it.left > 0; snake_iter_next(snake, &it)) {
+            Position pos = it.pos;
+            board_place_snake(board, pos.row, pos.col, id);
+            free_cells_remove(&free_cells, CELL_INDEX(pos.row, pos.col));
+        }
+        arena->died[id] = 0;
+        arena->kills[id] = 0;
+    }
+    score_set(ARENA_START_LENGTH);
+
+    arena->fruit_count = 0;
+    for (int i = 0; i < FRUIT_COUNT; i++) {
+        int cell = fruitSpawnRandom(board);
+        if (cell >= 0) {
+            arena->fruits[arena->fruit_count++] = cell;
+        }
+    }
+}
+
+/**
+ * @arg arena, the game
+ * @arg board, the board of the game
+ * Moves every living snake one step. The players are turned before
+ * this with changeDirectionSnake, the other snakes are steered here
+ */
+void arena_move(Arena *arena, Board *board)
+{
+    Position heads[ARENA_SNAKES];
+    unsigned int stamp = next_stamp(arena);
+    arena->moves++;
+
+    // where every head goes and what it runs into
+    for (int id = 0; id < ARENA_SNAKES; id++) {
+        Snake *snake = &arena->snakes[id];
+        if (!snake->snake_playing) {
+            continue;
+        }
+        if (id >= ARENA_PLAYERS) {
+            steer(arena, board, snake);
+        }
+        Position head = snake->head;
+        head.row += step_row[snake->direction & 3];
+        head.col += step_col[snake->direction & 3];
+        if ((unsigned) head.row >= BOARD_SIZE || (unsigned) head.col >= BOARD_SIZE) {
+            kill_snake(arena, id, -1);
+            continue;
+        }
+        if (board_is_snake(board, head.row, head.col)) {
+            kill_snake(arena, id, board_owner(board, head.row, head.col));
+            continue;
+        }
+        int cell = CELL_INDEX(head.row, head.col);
+        if (claimed(arena, cell)) { // head on
+            kill_snake(arena, id, -1);
+            kill_snake(arena, arena->claim[cell] & 0xFF, -1);
+            continue;
+        }
+        arena->claim[cell] = (stamp << 8) | id;
+        heads[id] = head;
+    }
+
+    // the survivors move, no two of them into the same cell
+    int eaten = 0;
+    for (int id = 0; id < ARENA_SNAKES; id++) {
+        Snake *snake = &arena->snakes[id];
+        if (!snake->snake_playing) {
+            continue;
+        }
+        Position head = heads[id];
+        if (board_is_fruit(board, head.row, head.col)) {
+            board_clear_fruit(board, head.row, head.col);
+            remove_fruit(arena, CELL_INDEX(head.row, head.col));
+            eaten++;
+        } else {
+            Position tail = snake->tail;
+            board_clear_snake(board, tail.row, tail.col);
+            removeTail(snake);
+        }
+        addHead(snake, head);
+        board_place_snake(board, head.row, head.col, id);
+    }
+
+    // new fruit only once every head is on the board, so none lands under one
+    for (; eaten > 0; eaten--) {
+        int cell = fruitSpawnRandom(board);
+        if (cell >= 0) {
+            arena->fruits[arena->fruit_count++] = cell;
+        }
+    }
+}
+
+/**
+ * @arg arena, the game
+ * @return true while one of the players is alive
+ */
+bool arena_playing(const Arena *arena)
+{
+    for (int id = 0; id < ARENA_PLAYERS; id++) {
+        if (arena->snakes[id].snake_playing) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Positive if player a did better than player b: alive for longer, then longer */
+static int compare(const Arena *arena, int a, int b)
+{
+    unsigned int died_a = arena->died[a] ? arena->died[a] : ~0u;
+    unsigned int died_b = arena->died[b] ? arena->died[b] : ~0u;
+    if (died_a != died_b) {
+        return died_a > died_b ? 1 : -1;
+    }
+    return arena->snakes[a].length - arena->snakes[b].length;
+}
+
+/**
+ * @arg arena, a game that is over
+ * @return the id of the player that won, -1 for a draw
+ */
+int arena_winner(const Arena *arena)
+{
+    int winner = 0;
+    bool draw = false;
+    for (int id = 1; id < ARENA_PLAYERS; id++) {
+        int c = compare(arena, id, winner);
+        if (c > 0) {
+            winner = id;
+            draw = false;
+        } else if (c == 0) {
+            draw = true;
+        }
+    }
+    return draw ? -1 : winner;
+}
@@ -0,0 +1,55 @@
+/* arena.h
+
+   Several snakes on one board: two players on their own switches and
+   snakes steered by the game. Every snake keeps its own ring of
+   segments and the board keeps which snake is on each cell (see
+   board_owner), so what a head runs into is known from the cell it
+   moves to without looking through any segments.
+
+   All snakes move in one pass per move. A head that moves into a body
+   or a wall dies, and the snake whose body it was gets a kill. Two
+   heads that move into the same cell are found with the claim map:
+   the first head stamps the cell with the number of the move and its
+   id, so the second one sees the stamp and both die. The stamps are
+   never cleared, an old stamp just has an old move number in it.
+
+   A dead snake stays on the board as a wall. The game goes on while
+   one of the players is alive. */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include "snake.h"
+#include "freecells.h"
+
+// Snakes on the board, the first ARENA_PLAYERS are steered from the
+// switches and the rest by the game
+#ifndef ARENA_SNAKES
+#define ARENA_SNAKES 4
+#endif
+#define ARENA_PLAYERS 2
+
+#if ARENA_SNAKES < ARENA_PLAYERS || ARENA_SNAKES >= BOARD_SIZE || ARENA_SNAKES > 255
+#error "ARENA_SNAKES needs a row of its own and an id that fits the owner map"
+#endif
+
+#define ARENA_START_LENGTH 3
+
+typedef struct {
+    Snake snakes[ARENA_SNAKES];         // indexed by id
+    unsigned int died[ARENA_SNAKES];    // move a snake died on, 0 while it is alive
+    int kills[ARENA_SNAKES];            // snakes that ran into this one
+    cell_index_t fruits[FRUIT_COUNT];   // where the fruits are, for the snakes the game steers
+    int fruit_count;
+    uint32_t claim[BOARD_SIZE * BOARD_SIZE]; // (stamp << 8) | id of the head moving into a cell
+    unsigned int stamp;                 // of the current move, keeps counting between games
+    unsigned int moves;
+} Arena;
+
+void arena_start(Arena *arena, Board *board);
+void arena_move(Arena *arena, Board *board);
+bool arena_playing(const Arena *arena);
+int arena_winner(const Arena *arena);
+
+#endif /* ARENA_H */
@@ -0,0 +1,231 @@
+/* autopilot.c
+
+   The Hamiltonian cycle goes along row 0, snakes back and forth
+   through columns 1.. of the other rows and returns up column 0. The
+   snake starts on it in cycle order (see startgame), and the body is
+   kept in that order from tail to head: the head only moves forward
+   on the cycle, possibly skipping cells, and never past the tail. The
+   tail can then always be reached by following the cycle, so the
+   snake cannot trap itself.
+
+   Skipping cells is what makes the snake faster than just following
+   the cycle. A skip is only taken while the snake is shorter than half
+   the board and leaves room ahead of the tail for the fruits it may
+   eat before the tail moves on. */
+
+#include "autopilot.h"
+#include "platform.h"
+
+#define CELLS (BOARD_SIZE * BOARD_SIZE)
+
+// Free cells kept between the head and the tail when skipping ahead
+#define SKIP_MARGIN (FRUIT_COUNT + 2)
+
+static const int drow[4] = {-1, 0, 1, 0}; // north, east, south, west
+static const int dcol[4] = {0, 1, 0, -1};
+
+/**
+ * @arg pilot, the autopilot to set up
+ * Builds the Hamiltonian cycle, done once
+ */
+void autopilot_init(Autopilot *pilot)
+{
+    int i = 0;
+    for (int col = 0; col < BOARD_SIZE; col++) {
+        pilot->cycle[CELL_INDEX(0, col)] = i++;
+    }
+    for (int row = 1; row < BOARD_SIZE; row++) {
+        for (int k = 1; k < BOARD_SIZE; k++) {
+            int col = (row & 1) ? BOARD_SIZE - k : k;
+            pilot->cycle[CELL_INDEX(row, col)] = i++;
+        }
+    }
+    for (int row = BOARD_SIZE - 1; row >= 1; row--) {
+        pilot->cycle[CELL_INDEX(row, 0)] = i++;
+    }
+    autopilot_reset(pilot);
+}
+
+/**
+ * @arg pilot, the autopilot
+ * Forgets the path and the statistics, called when a game starts
+ */
+void autopilot_reset(Autopilot *pilot)
+{
+    pilot->path_length = 0;
+    pilot->path_pos = 0;
+    pilot->decisions = 0;
+    pilot->worst_cycles = 0;
+}
+
+/* How far b is ahead of a going forward on the cycle */
+static inline int ahead(const Autopilot *pilot, int a, int b)
+{
+    int d = pilot->cycle[b] - pilot->cycle[a];
+    return d < 0 ? d + CELLS : d;
+}
+
+static inline void visit(Autopilot *pilot, int row, int col)
+{
+    pilot->visited[row][BOARD_WORD(col)] |= BOARD_BIT(col);
+}
+
+static inline bool visited(const Autopilot *pilot, int row, int col)
+{
+    return (pilot->visited[row][BOARD_WORD(col)] & BOARD_BIT(col)) != 0;
+}
+
+/* Breadth first search from the head to the nearest fruit, leaving the
+   path in pilot->path. Returns false if no fruit was found within
+   AUTOPILOT_SEARCH_LIMIT cells */
+static bool find_fruit(Autopilot *pilot, const Board *board, int head)
+{
+    for (int row = 0; row < BOARD_SIZE; row++) {
+        for (int w = 0; w < BOARD_ROW_WORDS; w++) {
+            pilot->visited[row][w] = 0;
+        }
+    }
+    int first = 0;
+    int last = 0;
+    pilot->queue[last++] = head;
+    visit(pilot, head / BOARD_SIZE, head % BOARD_SIZE);
+
+    while (first < last && first < AUTOPILOT_SEARCH_LIMIT) {
+        int cell = pilot->queue[first++];
+        int row = cell / BOARD_SIZE;
+        int col = cell % BOARD_SIZE;
+        if (cell != head && board_is_fruit(board, row, col)) {
+            // walk back to the head, then store the path head first
+            int length = 0;
+            for (int c = cell; c != head; length++) {
+                int d = pilot->from[c];
+                c -= drow[d] * BOARD_SIZE + dcol[d];
+            }
+            pilot->path_length = length;
+            pilot->path_pos = 0;
+            for (int c = cell; c != head; ) {
+                pilot->path[--length] = c;
+                int d = pilot->from[c];
+                c -= drow[d] * BOARD_SIZE + dcol[d];
+            }
+            return true;
+        }
+        for (int d = 0; d < 4; d++) {
+            int r = row + drow[d];
+            int c = col + dcol[d];
+            if (r < 0 || r >= BOARD_SIZE || c < 0 || c >= BOARD_SIZE
+                || visited(pilot, r, c) || board_is_snake(board, r, c)) {
+                continue;
+            }
+            visit(pilot, r, c);
+            pilot->from[CELL_INDEX(r, c)] = d;
+            pilot->queue[last++] = CELL_INDEX(r, c);
+        }
+    }
+    pilot->path_length = 0;
+    return false;
+}
+
+/* The path from the last search is still good if the head is where it
+   led and its fruit and next cell are still there */
+static bool path_valid(const Autopilot *pilot, const Board *board, int head)
+{
+    if (pilot->path_pos == 0 || pilot->path_pos >= pilot->path_length
+        || pilot->path[pilot->path_pos - 1] != head) {
+        return false;
+    }
+    int fruit = pilot->path[pilot->path_length - 1];
+    int next = pilot->path[pilot->path_pos];
+    return board_is_fruit(board, fruit / BOARD_SIZE, fruit % BOARD_SIZE)
+        && !board_is_snake(board, next / BOARD_SIZE, next % BOARD_SIZE);
+}
+
+/* Picks the cell to move to, see the top of the file */
+static int decide(Autopilot *pilot, const Snake *snake, const Board *board)
+{
+    Position h = snake->head;
+    Position t = snake->tail;
+    int head = CELL_INDEX(h.row, h.col);
+    int room = ahead(pilot, head, CELL_INDEX(t.row, t.col)); // cycle steps to the tail
+    bool skipping = snake->length < CELLS / 2;
+
+    if (!path_valid(pilot, board, head) && !find_fruit(pilot, board, head)) {
+        pilot->path_length = 0;
+    }
+    int limit = 1; // how far ahead on the cycle the move may go
+    if (pilot->path_length > 0) {
+        int fruit = pilot->path[pilot->path_length - 1];
+        int to_fruit = ahead(pilot, head, fruit);
+        limit = skipping ? room - SKIP_MARGIN : 1;
+        if (to_fruit < limit) {
+            limit = to_fruit; // no point in passing the fruit
+        }
+        if (limit < 1) {
+            limit = 1;
+        }
+        int next = pilot->path[pilot->path_pos];
+        int step = ahead(pilot, head, next);
+        if (step >= 1 && step <= limit) {
+            pilot->path_pos++;
+            return next;
+        }
+    }
+
+    // Off the path: the free neighbour furthest ahead within the limit,
+    // which is at least the next cell on the cycle
+    int best = -1;
+    int best_step = 0;
+    int any = -1;
+    for (int d = 0; d < 4; d++) {
+        int r = h.row + drow[d];
+        int c = h.col + dcol[d];
+        if (r < 0 || r >= BOARD_SIZE || c < 0 || c >= BOARD_SIZE || board_is_snake(board, r, c)) {
+            continue;
+        }
+        int cell = CELL_INDEX(r, c);
+        int step = ahead(pilot, head, cell);
+        any = cell;
+        if (step >= 1 && step <= limit && step > best_step) {
+            best = cell;
+            best_step = step;
+        }
+    }
+    pilot->path_pos = 0; // left the path, search again next move
+    return best >= 0 ? best : any; // any free cell if the order was broken
+}
+
+/**
+ * @arg pilot, the autopilot
+ * @arg snake, the snake to steer
+ * @arg board, the board of the game
+ * Decides the next move and turns the snake towards it, by setting
+ * the switches changeDirectionSnake reads
+ * @return the switches it set: bit 0 right and bit 1 left, like in runGame
+ */
+int autopilot_steer(Autopilot *pilot, Snake *snake, Board *board)
+{
+    unsigned int start = plat_cycles();
+    Position h = snake->head;
+    int target = decide(pilot, snake, board);
+    int switches = 0;
+    if (target >= 0) {
+        int d = snake->direction;
+        int row = target / BOARD_SIZE - h.row;
+        int col = target % BOARD_SIZE - h.col;
+        int want = row < 0 ? 0 : col > 0 ? 1 : row > 0 ? 2 : 3;
+        if (want == ((d + 1) & 3)) {
+            switches = 1; // right
+        } else if (want == ((d + 3) & 3)) {
+            switches = 2; // left
+        }
+    }
+    snake->right = switches & 1;
+    snake->left = (switches >> 1) & 1;
+
+    unsigned int cycles = plat_cycles() - start;
+    if (cycles > pilot->worst_cycles) {
+        pilot->worst_cycles = cycles;
+    }
+    pilot->decisions++;
+    return switches;
+}
@@ -0,0 +1,44 @@
+/* autopilot.h
+
+   A snake that steers itself, for the demo mode. Every move it looks
+   for the nearest fruit with a breadth first search and takes the
+   first step of the path when that keeps the tail reachable, otherwise
+   it follows a Hamiltonian cycle through the whole board. Started on
+   a new game and kept on, the snake always ends in gameWin.
+
+   Everything lives in the Autopilot struct, the search needs no heap
+   and the path is kept between moves as long as it is still good. */
+
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <stdbool.h>
+#include "snake.h"
+#include "freecells.h"
+
+#if BOARD_SIZE % 2 != 0
+#error "the autopilot needs an even BOARD_SIZE for its Hamiltonian cycle"
+#endif
+
+// Cells the search may visit in one move, which bounds its time in a large world
+#ifndef AUTOPILOT_SEARCH_LIMIT
+#define AUTOPILOT_SEARCH_LIMIT (BOARD_SIZE * BOARD_SIZE < 4096 ? BOARD_SIZE * BOARD_SIZE : 4096)
+#endif
+
+typedef struct {
+    cell_index_t cycle[BOARD_SIZE * BOARD_SIZE]; // where each cell is on the Hamiltonian cycle
+    cell_index_t queue[BOARD_SIZE * BOARD_SIZE]; // search queue
+    unsigned char from[BOARD_SIZE * BOARD_SIZE]; // direction each cell was reached in
+    board_row_t visited[BOARD_SIZE][BOARD_ROW_WORDS];
+    cell_index_t path[BOARD_SIZE * BOARD_SIZE];  // cells from the head to the fruit
+    int path_length;
+    int path_pos;       // next cell of path to move to
+    unsigned int decisions;
+    unsigned int worst_cycles; // of one decision, plat_cycles on the board
+} Autopilot;
+
+void autopilot_init(Autopilot *pilot);
+void autopilot_reset(Autopilot *pilot);
+int autopilot_steer(Autopilot *pilot, Snake *snake, Board *board);
+
+#endif /* AUTOPILOT_H */
@@ -0,0 +1,44 @@
+/* board.c
+
+   The game board as bitboards, see board.h */
+
+#include "board.h"
+
+/* Bits set in a word. Written out since __builtin_popcount would need
+   libgcc, which the -nostdlib build does not link */
+static inline int popcount(uint32_t x)
+{
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+    return (x * 0x01010101u) >> 24;
+}
+
+/**
+ * @arg board, the board to empty
+ * Both layers are cleared a row word at a time
+ */
+void board_clear(Board *board)
+{
+    for (int row = 0; row < BOARD_SIZE; row++) {
+        for (int word = 0; word < BOARD_ROW_WORDS; word++) {
+            board->snake[row][word] = 0;
+            board->fruit[row][word] = 0;
+        }
+    }
+}
+
+/**
+ * @arg board, the board to look at
+ * @return the number of cells with neither snake nor fruit on them
+ */
+int board_count_free(const Board *board)
+{
+    int used = 0;
+    for (int row = 0; row < BOARD_SIZE; row++) {
+        for (int word = 0; word < BOARD_ROW_WORDS; word++) {
+            used += popcount(board->snake[row][word] | board->fruit[row][word]);
+        }
+    }
+    return BOARD_SIZE * BOARD_SIZE - used;
+}
@@ -0,0 +1,112 @@
+/* board.h
+
+   The game board as bitboards: one bit per cell and one layer for
+   the snake and one for the fruit. A row of the board is one or more
+   words, so tests and updates of a cell are a shift and a mask and
+   clearing the board is a handful of word stores.
+
+   Next to the layers is the owner map, which snake is on each cell
+   (see arena.h). It is only read where the snake layer is set, so
+   clearing the board leaves it alone */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+
+// The size of the world in cells. The screen shows VIEW_SIZE cells
+// (see render.c), a larger world scrolls, e.g. make DEFS=-DBOARD_SIZE=256
+#ifndef BOARD_SIZE
+#define BOARD_SIZE 16
+#endif
+
+// Storage for the game state kept outside of Snake and Board (the random
+// generator, the free cells and the score). The batch simulator in
+// host/sim.c plays a game on every thread, so there each thread has its own
+#ifdef GAME_PER_THREAD
+#define GAME_LOCAL _Thread_local
+#else
+#define GAME_LOCAL
+#endif
+
+// What is on a cell, as returned by board_get
+#define CELL_EMPTY 0
+#define CELL_SNAKE 1
+#define CELL_FRUIT 2
+
+#if BOARD_SIZE <= 16
+typedef uint16_t board_row_t;
+#else
+typedef uint32_t board_row_t;
+#endif
+#define BOARD_ROW_BITS (8 * (int) sizeof(board_row_t))
+#define BOARD_ROW_WORDS ((BOARD_SIZE + BOARD_ROW_BITS - 1) / BOARD_ROW_BITS)
+
+typedef struct {
+    board_row_t snake[BOARD_SIZE][BOARD_ROW_WORDS];
+    board_row_t fruit[BOARD_SIZE][BOARD_ROW_WORDS];
+    unsigned char owner[BOARD_SIZE][BOARD_SIZE]; // id of the snake on a cell
+} Board;
+
+#define BOARD_WORD(col) ((col) / BOARD_ROW_BITS)
+#define BOARD_BIT(col) ((board_row_t) 1 << ((col) % BOARD_ROW_BITS))
+
+static inline int board_is_snake(const Board *board, int row, int col)
+{
+    return (board->snake[row][BOARD_WORD(col)] & BOARD_BIT(col)) != 0;
+}
+
+static inline int board_is_fruit(const Board *board, int row, int col)
+{
+    return (board->fruit[row][BOARD_WORD(col)] & BOARD_BIT(col)) != 0;
+}
+
+static inline int board_is_empty(const Board *board, int row, int col)
+{
+    return ((board->snake[row][BOARD_WORD(col)] | board->fruit[row][BOARD_WORD(col)]) & BOARD_BIT(col)) == 0;
+}
+
+static inline int board_get(const Board *board, int row, int col)
+{
+    if (board_is_snake(board, row, col))
+        return CELL_SNAKE;
+    if (board_is_fruit(board, row, col))
+        return CELL_FRUIT;
+    return CELL_EMPTY;
+}
+
+static inline void board_set_snake(Board *board, int row, int col)
+{
+    board->snake[row][BOARD_WORD(col)] |= BOARD_BIT(col);
+}
+
+static inline int board_owner(const Board *board, int row, int col)
+{
+    return board->owner[row][col];
+}
+
+static inline void board_place_snake(Board *board, int row, int col, int owner)
+{
+    board->snake[row][BOARD_WORD(col)] |= BOARD_BIT(col);
+    board->owner[row][col] = owner;
+}
+
+static inline void board_clear_snake(Board *board, int row, int col)
+{
+    board->snake[row][BOARD_WORD(col)] &= ~BOARD_BIT(col);
+}
+
+static inline void board_set_fruit(Board *board, int row, int col)
+{
+    board->fruit[row][BOARD_WORD(col)] |= BOARD_BIT(col);
+}
+
+static inline void board_clear_fruit(Board *board, int row, int col)
+{
+    board->fruit[row][BOARD_WORD(col)] &= ~BOARD_BIT(col);
+}
+
+void board_clear(Board *board);
+int board_count_free(const Board *board);
+
+#endif /* BOARD_H */
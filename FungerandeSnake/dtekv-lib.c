@@ -1,12 +1,76 @@
 #include "dtekv-lib.h"
+#include "platform.h"
 
-#define JTAG_UART ((volatile unsigned int*) 0x04000040)
-#define JTAG_CTRL ((volatile unsigned int*) 0x04000044)
+/* Output is queued in a ring buffer and written to the JTAG UART by
+   print_drain, so printing never waits for the host. When the buffer
+   is full new characters are dropped, or with -DJTAG_TX_BLOCK the
+   oldest ones are written out synchronously to make room. */
+#ifndef JTAG_TX_SIZE
+#define JTAG_TX_SIZE 1024 // power of two
+#endif
+
+static char tx_buffer[JTAG_TX_SIZE];
+static volatile unsigned int tx_head; // next free slot, moved by printc
+static volatile unsigned int tx_tail; // next to write, moved by print_drain
+static unsigned int tx_dropped;
+static char tx_sync; // set by handle_exception, write straight through
+
+/**
+ * Writes queued characters while the UART has room for them
+ * @return the number of characters still queued
+ */
+int print_drain(void)
+{
+  unsigned int tail = tx_tail;
+  while (tail != tx_head && plat_jtag_space() != 0) {
+    plat_jtag_write(tx_buffer[tail & (JTAG_TX_SIZE - 1)]);
+    tail++;
+  }
+  tx_tail = tail;
+  return tx_head - tail;
+}
+
+/**
+ * @return the number of characters queued but not written yet
+ */
+int print_pending(void)
+{
+  return tx_head - tx_tail;
+}
+
+/**
+ * @return how many characters were dropped on a full buffer
+ */
+unsigned int print_dropped(void)
+{
+  return tx_dropped;
+}
+
+/**
+ * Writes everything that is queued, waiting for the UART
+ */
+void print_flush(void)
+{
+  while (print_drain() != 0);
+}
 
 void printc(char s)
 {
-    while (((*JTAG_CTRL)&0xffff0000) == 0);
-    *JTAG_UART = s;
+  if (tx_sync) {
+    while (plat_jtag_space() == 0);
+    plat_jtag_write(s);
+    return;
+  }
+  if (tx_head - tx_tail == JTAG_TX_SIZE) {
+#ifdef JTAG_TX_BLOCK
+    while (print_drain() == JTAG_TX_SIZE);
+#else
+    tx_dropped++;
+    return;
+#endif
+  }
+  tx_buffer[tx_head & (JTAG_TX_SIZE - 1)] = s;
+  tx_head = tx_head + 1;
 }
 
 void print(char *s)
@@ -51,6 +115,11 @@ void print_hex32 ( unsigned int x)
    Description: This code handles an exception. */
 void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned arg3, unsigned arg4, unsigned arg5, unsigned mcause, unsigned syscall_num )
 {
+  if (mcause != 11) {
+    // the program stops here, so get the queued output out first
+    print_flush();
+    tx_sync = 1;
+  }
   switch (mcause)
     {
     case 0:
@@ -61,7 +130,7 @@ void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned ar
       break;
     case 11:
       if (syscall_num == 4)
-	print((char*) arg0); 
+	print((char*) (uintptr_t) arg0); 
       if (syscall_num == 11)
 	printc(arg0);
       return ;
@@ -76,51 +145,139 @@ void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned ar
   while (1);
 }
 
+/* Primes for nextprime. Below PRIME_TRIAL_LIMIT a number is tested by
+   trial division up to its square root, over the numbers a wheel of 30
+   leaves (those not divisible by 2, 3 or 5). Above it the small primes
+   only throw out most composites early and Miller-Rabin with the bases
+   2, 7 and 61 decides, which is exact for every number below
+   4759123141 and so for every unsigned int. Its products are done in
+   Montgomery form, so the only division is one 32-bit remainder per
+   number and there are no 64-bit divisions for libgcc to provide. */
+#define PRIME_TRIAL_LIMIT (1u << 16) // sqrt at most 256, under 70 divisions
+
+static const unsigned char small_primes[] = {7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47};
+
+// Steps from one number not divisible by 2, 3 or 5 to the next, from 1 mod 30
+static const unsigned char wheel_steps[8] = {6, 4, 2, 4, 2, 4, 6, 2};
+
+/* a * b / 2^32 mod n for a, b < n, with minus_inverse = -1/n mod 2^32 */
+static inline unsigned int mont_mul(unsigned int a, unsigned int b, unsigned int n, unsigned int minus_inverse)
+{
+  uint64_t t = (uint64_t) a * b;
+  unsigned int m = (unsigned int) t * minus_inverse;
+  uint64_t mn = (uint64_t) m * n;
+  // the low halves add up to 0 mod 2^32, with a carry unless both are 0
+  uint64_t u = (t >> 32) + (mn >> 32) + ((unsigned int) t != 0);
+  return (unsigned int) (u >= n ? u - n : u);
+}
+
+/**
+ * @arg n, odd and above PRIME_TRIAL_LIMIT
+ * @return true if no base of 2, 7 and 61 is a witness that n is composite
+ */
+static int miller_rabin(unsigned int n)
+{
+  static const unsigned char bases[3] = {2, 7, 61};
+  unsigned int inverse = n; // right to 3 bits for odd n, each step doubles that
+  for (int i = 0; i < 4; i++)
+    inverse *= 2 - n * inverse;
+  unsigned int minus_inverse = -inverse;
+  unsigned int one = (0u - n) % n; // 2^32 mod n
+  unsigned int minus_one = n - one;
+  unsigned int r2 = one;           // 2^64 mod n, for going into Montgomery form
+  for (int i = 0; i < 32; i++)
+    r2 = r2 >= n - r2 ? r2 - (n - r2) : r2 + r2;
+
+  unsigned int d = n - 1;
+  int s = 0;
+  while ((d & 1) == 0) {
+    d >>= 1;
+    s++;
+  }
+  for (int b = 0; b < 3; b++) {
+    unsigned int base = mont_mul(bases[b], r2, n, minus_inverse);
+    unsigned int x = one;
+    for (unsigned int bit = 1u << 31; bit != 0; bit >>= 1) { // x = base^d
+      x = mont_mul(x, x, n, minus_inverse);
+      if (d & bit)
+        x = mont_mul(x, base, n, minus_inverse);
+    }
+    if (x == one || x == minus_one)
+      continue;
+    int i;
+    for (i = 1; i < s; i++) {
+      x = mont_mul(x, x, n, minus_inverse);
+      if (x == minus_one)
+        break;
+    }
+    if (i == s)
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * @arg n, not divisible by 2, 3 or 5
+ * @return 1 if n is prime
+ */
+static int wheel_prime(unsigned int n)
+{
+  if (n < PRIME_TRIAL_LIMIT) {
+    unsigned int d = 7;
+    for (int i = 1; d * d <= n; d += wheel_steps[i++ & 7]) {
+      if (n % d == 0)
+        return 0;
+    }
+    return n > 1;
+  }
+  for (unsigned int i = 0; i < sizeof(small_primes); i++) {
+    if (n % small_primes[i] == 0)
+      return 0;
+  }
+  return miller_rabin(n);
+}
+
+/**
+ * @arg n, any unsigned int
+ * @return the first prime larger than n, 0 if that does not fit an
+ * unsigned int (n is 4294967291 or more)
+ */
+unsigned int nextprime_u32(unsigned int n)
+{
+  if (n < 5)
+    return n < 2 ? 2 : n < 3 ? 3 : 5;
+  // the first number after n that the wheel keeps, and its place on the wheel
+  static const unsigned char next_spoke[30] = {
+    1, 7, 7, 7, 7, 7, 7, 11, 11, 11, 11, 13, 13, 17, 17, 17, 17, 19, 19, 23, 23, 23, 23, 29, 29, 29, 29, 29, 29, 31};
+  static const unsigned char spoke_index[32] = {
+    0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 2, 0, 3, 0, 0, 0, 4, 0, 5, 0, 0, 0, 6, 0, 0, 0, 0, 0, 7, 0, 0};
+  unsigned int r = n % 30;
+  unsigned int offset = next_spoke[r];
+  int spoke = offset == 31 ? 0 : spoke_index[offset];
+  if (n > 0xFFFFFFFFu - (offset - r))
+    return 0;
+  unsigned int candidate = n - r + offset;
+  while (!wheel_prime(candidate)) {
+    unsigned int step = wheel_steps[spoke];
+    if (candidate > 0xFFFFFFFFu - step)
+      return 0;
+    candidate += step;
+    spoke = (spoke + 1) & 7;
+  }
+  return candidate;
+}
+
 /*
  * nextprime
  * 
  * Return the first prime number larger than the integer
- * given as a parameter. The integer must be positive.
+ * given as a parameter, 1 for zero or negative input, and 0 if
+ * the prime does not fit an int. See nextprime_u32.
  */
-#define PRIME_FALSE   0     /* Constant to help readability. */
-#define PRIME_TRUE    1     /* Constant to help readability. */
 int nextprime( int inval )
 {
-   register int perhapsprime = 0; /* Holds a tentative prime while we check it. */
-   register int testfactor; /* Holds various factors for which we test perhapsprime. */
-   register int found;      /* Flag, false until we find a prime. */
-
-   if (inval < 3 )          /* Initial sanity check of parameter. */
-   {
-     if(inval <= 0) return(1);  /* Return 1 for zero or negative input. */
-     if(inval == 1) return(2);  /* Easy special case. */
-     if(inval == 2) return(3);  /* Easy special case. */
-   }
-   else
-   {
-     /* Testing an even number for primeness is pointless, since
-      * all even numbers are divisible by 2. Therefore, we make sure
-      * that perhapsprime is larger than the parameter, and odd. */
-     perhapsprime = ( inval + 1 ) | 1 ;
-   }
-   /* While prime not found, loop. */
-   for( found = PRIME_FALSE; found != PRIME_TRUE; perhapsprime += 2 )
-   {
-     /* Check factors from 3 up to perhapsprime/2. */
-     for( testfactor = 3; testfactor <= (perhapsprime >> 1) + 1; testfactor += 1 )
-     {
-       found = PRIME_TRUE;      /* Assume we will find a prime. */
-       if( (perhapsprime % testfactor) == 0 ) /* If testfactor divides perhapsprime... */
-       {
-         found = PRIME_FALSE;   /* ...then, perhapsprime was non-prime. */
-         goto check_next_prime; /* Break the inner loop, go test a new perhapsprime. */
-       }
-     }
-     check_next_prime:;         /* This label is used to break the inner loop. */
-     if( found == PRIME_TRUE )  /* If the loop ended normally, we found a prime. */
-     {
-       return( perhapsprime );  /* Return the prime we found. */
-     } 
-   }
-   return( perhapsprime );      /* When the loop ends, perhapsprime is a real prime. */
-} 
+  if (inval <= 0)
+    return 1;
+  unsigned int prime = nextprime_u32(inval);
+  return prime > 0x7FFFFFFFu ? 0 : (int) prime;
+}
@@ -2,8 +2,13 @@ void printc(char );
 void print(char *);
 void print_dec(unsigned int);
 void print_hex32 ( unsigned int);
+int print_drain(void);
+int print_pending(void);
+void print_flush(void);
+unsigned int print_dropped(void);
 void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned arg3, unsigned arg4, unsigned arg5, unsigned mcause, unsigned syscall_num );
 int nextprime( int inval );
+unsigned int nextprime_u32(unsigned int n);
 
 
 
@@ -0,0 +1,75 @@
+/* freecells.c
+
+   Set of the empty cells on the board.
+
+   cells is a dense array where the first count entries are the empty
+   cells, in no particular order, and the rest are the occupied ones.
+   slot maps a cell back to its place in cells. Removing a cell swaps
+   it with the last empty one and adding it swaps it with the first
+   occupied one, so both are O(1), and a random empty cell is just
+   cells[random % count]. */
+
+#include "freecells.h"
+
+/**
+ * @arg set, the set to reset
+ * Marks every cell of the board as empty
+ */
+void free_cells_init(FreeCells *set)
+{
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+        set->cells[i] = i;
+        set->slot[i] = i;
+    }
+    set->count = BOARD_SIZE * BOARD_SIZE;
+}
+
+static inline void swap_slots(FreeCells *set, int a, int b)
+{
+    cell_index_t cell_a = set->cells[a];
+    cell_index_t cell_b = set->cells[b];
+    set->cells[a] = cell_b;
+    set->cells[b] = cell_a;
+    set->slot[cell_b] = a;
+    set->slot[cell_a] = b;
+}
+
+/**
+ * @arg set, the set of empty cells
+ * @arg cell, the cell that is no longer empty
+ * Does nothing if the cell already was occupied
+ */
+void free_cells_remove(FreeCells *set, int cell)
+{
+    int slot = set->slot[cell];
+    if (slot < set->count) {
+        set->count--;
+        swap_slots(set, slot, set->count);
+    }
+}
+
+/**
+ * @arg set, the set of empty cells
+ * @arg cell, the cell that became empty
+ * Does nothing if the cell already was empty
+ */
+void free_cells_add(FreeCells *set, int cell)
+{
+    int slot = set->slot[cell];
+    if (slot >= set->count) {
+        swap_slots(set, slot, set->count);
+        set->count++;
+    }
+}
+
+/**
+ * @arg set, the set of empty cells, must not be empty
+ * @arg random, a random 32-bit value
+ * @return an empty cell, chosen uniformly
+ * The value is scaled with a multiply instead of % so no division is needed
+ */
+int free_cells_pick(FreeCells *set, unsigned int random)
+{
+    unsigned int slot = (unsigned int) (((unsigned long long) random * set->count) >> 32);
+    return set->cells[slot];
+}
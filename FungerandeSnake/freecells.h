@@ -0,0 +1,33 @@
+/* freecells.h
+
+   Set of the empty cells on the board, so a fruit can be placed with
+   one random draw no matter how full the board is */
+
+#ifndef FREECELLS_H
+#define FREECELLS_H
+
+#include "snake.h"
+
+// A cell is numbered row * BOARD_SIZE + col
+#define CELL_INDEX(row, col) ((row) * BOARD_SIZE + (col))
+
+#if BOARD_SIZE <= 256
+typedef unsigned short cell_index_t;
+#else
+typedef unsigned int cell_index_t;
+#endif
+
+typedef struct {
+    cell_index_t cells[BOARD_SIZE * BOARD_SIZE]; // the first count entries are the empty cells
+    cell_index_t slot[BOARD_SIZE * BOARD_SIZE];  // where each cell is in cells
+    int count;
+} FreeCells;
+
+extern GAME_LOCAL FreeCells free_cells; // the set for the board in play, see snake.c
+
+void free_cells_init(FreeCells *set);
+void free_cells_remove(FreeCells *set, int cell);
+void free_cells_add(FreeCells *set, int cell);
+int free_cells_pick(FreeCells *set, unsigned int random);
+
+#endif /* FREECELLS_H */
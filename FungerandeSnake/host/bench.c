@@ -0,0 +1,367 @@
+/* bench.c
+
+   Native benchmark of the game hot paths, built with make bench.
+   Plays games with a simple steering rule on the host backend
+   (see platform.h) and reports the time per moveSnake and per frame,
+   then the cost of spawning a fruit as the board fills up.
+
+   Usage: snake-bench [moves] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "platform.h"
+#include "snake.h"
+#include "render.h"
+#include "sched.h"
+#include "hud.h"
+#include "arena.h"
+#include "freecells.h"
+#include "vga.h"
+#include "probe.h"
+#include "autopilot.h"
+#include "dtekv-lib.h"
+
+static unsigned long long now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Cost of the two clock reads around a measured call */
+static double timer_overhead_ns(void)
+{
+  const int rounds = 100000;
+  unsigned long long total = 0;
+  for (int i = 0; i < rounds; i++) {
+    unsigned long long t0 = now_ns();
+    total += now_ns() - t0;
+  }
+  return (double) total / rounds;
+}
+
+static bool safe(Snake *snake, Board *board, int direction)
+{
+  static const int drow[4] = {-1, 0, 1, 0};
+  static const int dcol[4] = {0, 1, 0, -1};
+  Position head = snake->head;
+  int row = head.row + drow[direction];
+  int col = head.col + dcol[direction];
+  if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE)
+    return false;
+  return !board_is_snake(board, row, col);
+}
+
+/* Turn randomly now and then, and away from walls and the body */
+static void steer(Snake *snake, Board *board, unsigned int *rng)
+{
+  bool options[3][2] = {{true, true}, {true, false}, {false, true}}; // straight, right, left
+  int first = (rand_r(rng) % 4 == 0) ? 1 + rand_r(rng) % 2 : 0;
+  for (int i = 0; i < 3; i++) {
+    bool *turn = options[(first + i) % 3];
+    if (safe(snake, board, calculateDirectionChange(turn[0], turn[1], snake->direction))) {
+      changeDirectionSnake(snake, turn[0], turn[1]);
+      return;
+    }
+  }
+  changeDirectionSnake(snake, true, true);
+}
+
+static void new_game(Snake *snake, Board *board)
+{
+  startgame(snake, board);
+  invalidate_board();
+}
+
+/* The old fruitSpawnRandom, which retried random cells until it hit an empty one */
+static int spawn_rejection(Board *board)
+{
+  int x, y;
+  do {
+    unsigned int tmp = (unsigned int) seed;
+    x = random_value(&tmp) % BOARD_SIZE;
+    y = random_value(&tmp) % BOARD_SIZE;
+  } while (!board_is_empty(board, x, y));
+  board_set_fruit(board, x, y);
+  return CELL_INDEX(x, y);
+}
+
+/* Takes the fruit off a cell again and gives the cell back to the set,
+   which does nothing to the set if the cell is in it already */
+static void unspawn(Board *board, int cell)
+{
+  board_clear_fruit(board, cell / BOARD_SIZE, cell % BOARD_SIZE);
+  free_cells_add(&free_cells, cell);
+}
+
+/* Fills the board to the given number of occupied cells and times
+   spawning a fruit with the free-cell set against the old retry loop.
+   A spawn is far shorter than a clock read, so each is timed as a batch
+   of spawns, each undone for the next, less a batch of only the undoing */
+static void bench_spawn(Board *board, int occupied)
+{
+  enum { ROUNDS = 200000 };
+  static int taken[ROUNDS]; // the cells of the spawns, undone again in the last batch
+  unsigned int rng = 7;
+
+  board_clear(board);
+  free_cells_init(&free_cells);
+  while (free_cells.count > BOARD_SIZE * BOARD_SIZE - occupied) {
+    int cell = free_cells_pick(&free_cells, rand_r(&rng) * 2654435761u);
+    board_set_snake(board, cell / BOARD_SIZE, cell % BOARD_SIZE);
+    free_cells_remove(&free_cells, cell);
+  }
+
+  unsigned long long t0 = now_ns();
+  for (int i = 0; i < ROUNDS; i++) {
+    taken[i] = fruitSpawnRandom(board);
+    unspawn(board, taken[i]);
+  }
+  unsigned long long set_ns = now_ns() - t0;
+
+  t0 = now_ns();
+  for (int i = 0; i < ROUNDS; i++)
+    unspawn(board, spawn_rejection(board));
+  unsigned long long retry_ns = now_ns() - t0;
+
+  t0 = now_ns();
+  for (int i = 0; i < ROUNDS; i++)
+    unspawn(board, taken[i]);
+  unsigned long long undo_ns = now_ns() - t0;
+
+  printf("spawn %3d/%d full: %8.1f ns free-cell set, %8.1f ns retry loop\n",
+         occupied, BOARD_SIZE * BOARD_SIZE,
+         ((double) set_ns - undo_ns) / ROUNDS, ((double) retry_ns - undo_ns) / ROUNDS);
+}
+
+/* Whole games steered by the autopilot: how often it wins and what a
+   decision costs, the worst case is what has to fit in a move */
+static void bench_autopilot(void)
+{
+  static Autopilot pilot;
+  static Board board;
+  static Snake snake;
+  const int games = 20;
+  int wins = 0;
+  unsigned long long ns = 0, decisions = 0;
+  unsigned int worst = 0;
+
+  autopilot_init(&pilot);
+  for (int g = 0; g < games; g++) {
+    new_game(&snake, &board);
+    autopilot_reset(&pilot);
+    while (snake.snake_playing) {
+      unsigned long long t0 = now_ns();
+      autopilot_steer(&pilot, &snake, &board);
+      ns += now_ns() - t0;
+      changeDirectionSnake(&snake, snake.right, snake.left);
+      moveSnake(&snake, &board);
+    }
+    wins += snake.length >= BOARD_SIZE * BOARD_SIZE;
+    decisions += pilot.decisions;
+    if (pilot.worst_cycles > worst)
+      worst = pilot.worst_cycles;
+  }
+  printf("autopilot:      %8.1f ns/decision, worst %u ns, %d/%d games won, %llu moves/game\n",
+         (double) ns / decisions, worst, wins, games, decisions / games);
+}
+
+/* Arena games with the players turning at random: the cost of moving
+   one snake while the snakes are short and once they have grown, which
+   should be the same since a move looks at one cell per snake */
+static void bench_arena(double overhead)
+{
+  static Arena arena;
+  static Board board;
+  unsigned int rng = 7;
+  const int games = 2000;
+  unsigned long long ns[2] = {0, 0}, moves[2] = {0, 0}, snake_moves[2] = {0, 0};
+  int longest = 0;
+
+  for (int g = 0; g < games; g++) {
+    arena_start(&arena, &board);
+    // players that never turn into anything can go on forever on a full board
+    for (int m = 0; m < 20000 && arena_playing(&arena); m++) {
+      int length = 0, living = 0;
+      for (int id = 0; id < ARENA_SNAKES; id++) {
+        if (id < ARENA_PLAYERS && arena.snakes[id].snake_playing)
+          steer(&arena.snakes[id], &board, &rng);
+        length += arena.snakes[id].length;
+        living += arena.snakes[id].snake_playing;
+      }
+      int grown = length >= 2 * ARENA_SNAKES * ARENA_START_LENGTH;
+      unsigned long long t0 = now_ns();
+      arena_move(&arena, &board);
+      ns[grown] += now_ns() - t0;
+      moves[grown]++;
+      snake_moves[grown] += living;
+      if (length > longest)
+        longest = length;
+    }
+  }
+  printf("arena_move:     %8.1f ns/snake short, %.1f ns/snake grown (%d snakes, %llu moves, longest %d cells)\n",
+         (ns[0] - overhead * moves[0]) / snake_moves[0],
+         snake_moves[1] ? (ns[1] - overhead * moves[1]) / snake_moves[1] : 0.0,
+         ARENA_SNAKES, moves[0] + moves[1], longest);
+}
+
+/* Frames in between moves with the head and tail sliding, ten per move,
+   against the frame right after a move which draws the changed cells.
+   A frame is too short to time on its own, so each move times its frame
+   loop with one clock pair: the two frames after the move and the eight
+   in between */
+static void bench_animation(void)
+{
+  static Board board;
+  static Snake snake;
+  unsigned int rng = 11;
+  const int moves = 100000, frames = 10;
+  unsigned long long move_ns = 0, between_ns = 0;
+
+  new_game(&snake, &board);
+  for (int i = 0; i < moves; i++) {
+    if (!snake.snake_playing)
+      new_game(&snake, &board);
+    steer(&snake, &board, &rng);
+    Position old_tail = snake.tail;
+    moveSnake(&snake, &board);
+    if (!snake.snake_playing) {
+      render_animate_stop();
+      continue;
+    }
+    render_animate_move(&snake, old_tail);
+    unsigned long long t0 = now_ns();
+    for (int f = 0; f < frames; f++) {
+      if (f == 2) { // both pages have drawn the changed cells once
+        unsigned long long t1 = now_ns();
+        move_ns += t1 - t0;
+        t0 = t1;
+      }
+      render_animate_progress(f * SCHED_PROGRESS_ONE / frames);
+      render_dirty(&board, &snake);
+      vga_present();
+    }
+    between_ns += now_ns() - t0;
+  }
+  render_animate_stop();
+  printf("animation:      %8.1f ns/frame in between moves, %.1f ns/frame after a move\n",
+         between_ns / (double) (moves * (frames - 2)), move_ns / (double) (moves * 2));
+}
+
+/* One changed digit per frame like during a game, and the whole line,
+   each timed as one batch of frames */
+static void bench_hud(void)
+{
+  const int frames = 1000000, full_frames = 10000;
+  unsigned long long t0 = now_ns();
+  for (int i = 0; i < frames; i++) {
+    hud_bcd(0, i & 7, 6); // the score digits, as update_hud sets them
+    hud_render(i & 1);
+  }
+  unsigned long long digit_ns = now_ns() - t0;
+
+  t0 = now_ns();
+  for (int i = 0; i < full_frames; i++) {
+    hud_invalidate();
+    hud_render(0);
+  }
+  unsigned long long full_ns = now_ns() - t0;
+  printf("hud_render:     %8.1f ns/frame changing a digit, %.1f ns the whole line\n",
+         digit_ns / (double) frames, full_ns / (double) full_frames);
+}
+
+/* nextprime_u32 from random numbers in every fourth power of two up to
+   2^32, where it goes from trial division to Miller-Rabin at 2^16. The
+   numbers are drawn first and the calls timed as one batch */
+static void bench_nextprime(void)
+{
+  enum { CALLS = 20000 };
+  static unsigned int numbers[CALLS];
+  unsigned int rng = 7;
+  unsigned int checksum = 0;
+  printf("nextprime_u32: ");
+  for (int bits = 8; bits <= 32; bits += 4) {
+    unsigned int low = 1u << (bits - 1);
+    for (int i = 0; i < CALLS; i++)
+      numbers[i] = low + ((((unsigned int) rand_r(&rng) << 16) ^ rand_r(&rng)) & (low - 1));
+    unsigned long long t0 = now_ns();
+    for (int i = 0; i < CALLS; i++)
+      checksum += nextprime_u32(numbers[i]);
+    unsigned long long ns = now_ns() - t0;
+    printf(" 2^%d %.0f ns", bits, ns / (double) CALLS);
+  }
+  printf(" (checksum %08x)\n", checksum);
+}
+
+int main(int argc, char **argv)
+{
+  long moves = argc > 1 ? atol(argv[1]) : 1000000;
+  static Board board;
+  static Snake snake;
+  unsigned int rng = 1;
+  unsigned int tmp = 1234567890;
+  unsigned long long move_ns = 0, frame_ns = 0, full_ns = 0;
+  long frames = 0, full_frames = 0, games = 1;
+
+  host_set_quiet(1);
+  seed = random_value(&tmp);
+  vga_init();
+  hud_init();
+  double overhead = timer_overhead_ns();
+
+  new_game(&snake, &board);
+  for (long i = 0; i < moves; i++) {
+    if (!snake.snake_playing) {
+      new_game(&snake, &board);
+      games++;
+    }
+    steer(&snake, &board, &rng);
+
+    unsigned long long t0 = now_ns();
+    PROBE_BEGIN(PROBE_MOVE);
+    moveSnake(&snake, &board);
+    PROBE_END(PROBE_MOVE);
+    unsigned long long t1 = now_ns();
+    PROBE_BEGIN(PROBE_RENDER);
+    render_dirty(&board, &snake);
+    PROBE_END(PROBE_RENDER);
+    vga_present();
+    unsigned long long t2 = now_ns();
+
+    move_ns += t1 - t0;
+    frame_ns += t2 - t1;
+    frames++;
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    unsigned long long t0 = now_ns();
+    render_board(&board, &snake);
+    full_ns += now_ns() - t0;
+    full_frames++;
+  }
+
+  printf("games played:   %ld\n", games);
+  printf("moveSnake:      %8.1f ns/call (%ld calls)\n", move_ns / (double) moves - overhead, moves);
+  printf("render_dirty:   %8.1f ns/frame (%ld frames)\n", frame_ns / (double) frames - overhead, frames);
+  printf("render_board:   %8.1f ns/frame (%ld frames)\n", full_ns / (double) full_frames - overhead, full_frames);
+  printf("clock overhead: %8.1f ns (subtracted)\n", overhead);
+  printf("Snake:          %8zu bytes\n", sizeof(Snake));
+
+  const int cells = BOARD_SIZE * BOARD_SIZE;
+  int fills[] = {0, cells / 4, cells / 2, cells * 3 / 4, cells * 9 / 10, cells - 8, cells - 1};
+  for (unsigned int i = 0; i < sizeof(fills) / sizeof(fills[0]); i++)
+    bench_spawn(&board, fills[i]);
+
+  bench_hud();
+  bench_animation();
+  bench_arena(overhead);
+  bench_autopilot();
+  bench_nextprime();
+
+  while (print_drain() != 0); // the game over messages, still quiet
+  host_set_quiet(0);
+  probe_dump(); // in nanoseconds here, built with make bench DEFS=-DPROBES
+  while (print_drain() != 0);
+  return 0;
+}
@@ -0,0 +1,734 @@
+/* emu.c
+
+   Instruction set simulator for the DTEK-V board, built with make emu.
+   Runs main.bin itself, the exact binary that goes to the board, so a
+   build can be timed without board time. The core is RV32IM with
+   Zicsr, the devices are the ones in platform.h: LEDs, switches,
+   buttons, the interval timer, the JTAG UART, the 7-segment displays
+   and the VGA pixel buffer with its DMA controller.
+
+   The binary is loaded at address 0 like dtekv-script.lds links it and
+   the core starts at 4, the reset jump of boot.S. Time is counted in
+   modelled cycles of the 30 MHz clock, and the timer, vertical sync and
+   scripted inputs all run on that clock, so a run is deterministic.
+   A wfi skips straight to the next event.
+
+   The cycle model is a simple in-order core: one cycle per instruction
+   plus the extra costs in the CYCLES_* constants below. It is meant for
+   comparing builds with each other, not for matching the board to the
+   cycle.
+
+   Interrupts: the boot code sets bits 0 and 1 of mstatus and bits that
+   do not match the causes in mie, so here any of the MSTATUS_IRQ_BITS
+   enables interrupts and mie does not mask them. The devices mask
+   their own requests (timer ITO, switch and button interrupt masks).
+   mtvec works in direct and vectored mode.
+
+   Usage: snake-emu [-q] [-t ms] [-s script] [-o out.ppm] [-T ticks.csv] [main.bin]
+     -q  do not print the JTAG UART output
+     -t  stop after this many milliseconds of modelled time (default 10000)
+     -s  script of inputs, lines of "<ms> sw <value>", "<ms> btn <value>",
+         "<ms> ppm <file>" or "<ms> end", in order of time
+     -o  write the frame on screen at the end to a PPM file
+     -T  write the instructions and cycles of every timer tick as CSV
+
+   At the end it prints the instructions retired and cycles used between
+   timer interrupts ("ticks"), counting only the cycles the core was not
+   sleeping in wfi. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define CLOCK_HZ 30000000
+#define CYCLES_PER_MS (CLOCK_HZ / 1000)
+#define VSYNC_CYCLES (CLOCK_HZ / 60)
+
+// Extra cycles on top of one per instruction
+#define CYCLES_LOAD 1          // load use
+#define CYCLES_TAKEN 2         // taken branch or jump, the fetch restarts
+#define CYCLES_MUL 2
+#define CYCLES_DIV 32          // one bit per cycle
+#define CYCLES_IO 4            // a device register instead of memory
+#define CYCLES_TRAP 3          // entering a trap or mret
+
+#define RAM_SIZE (32 << 20)    // see dtekv-script.lds
+#define RESET_PC 4
+
+// Devices, see platform.h
+#define IO_BASE 0x04000000u
+#define IO_SIZE 0x200
+#define VGA_BASE 0x08000000u
+#define VGA_WIDTH 320
+#define VGA_HEIGHT 240
+#define VGA_BYTES (VGA_WIDTH * VGA_HEIGHT)
+
+#define MSTATUS_IRQ_BITS 0xB
+#define CAUSE_TIMER 16
+#define CAUSE_SWITCH 17
+#define CAUSE_BUTTON 18
+
+typedef struct {
+  uint64_t cycle;
+  enum { EV_SWITCHES, EV_BUTTONS, EV_PPM, EV_END } kind;
+  int value;
+  char file[128];
+} ScriptEvent;
+
+static uint8_t *ram;
+static uint8_t vga[VGA_BYTES];
+
+// The core
+static uint32_t x[32];
+static uint32_t pc;
+static uint64_t cycles;        // modelled time
+static uint64_t instret;
+static uint64_t sleep_cycles;  // spent in wfi
+static uint32_t mstatus, mie, mtvec, mscratch, mepc, mcause, mtval;
+static uint32_t saved_irq_bits; // mstatus & MSTATUS_IRQ_BITS when the trap came
+static uint64_t exceptions;
+
+// The devices
+static uint32_t leds;
+static uint32_t switches, switch_mask, switch_edge;
+static uint32_t buttons, button_mask, button_edge;
+static uint32_t segments[6];
+static uint32_t timer_period, timer_control;
+static int timer_running, timer_timeout;
+static uint64_t timer_start;    // cycle the counter was at the period
+static uint32_t timer_snapshot;
+static uint32_t vga_front = VGA_BASE, vga_back = VGA_BASE;
+static int vga_swap_requested;
+static uint64_t next_vsync = VSYNC_CYCLES;
+static uint64_t devices_due;    // run_devices before this cycle has nothing to do
+static int quiet;
+static uint64_t uart_bytes;
+
+// Per tick statistics, a tick ends at every timer timeout
+static uint64_t tick_instret, tick_busy;    // at the start of the tick
+static uint64_t ticks, tick_instr_sum, tick_cycles_sum;
+static uint64_t tick_instr_max, tick_cycles_max;
+static FILE *tick_csv;
+
+static ScriptEvent *script;
+static int script_count, script_pos;
+static int finished;
+
+static void write_ppm(const char *file);
+
+static uint64_t timer_expiry(void)
+{
+  return timer_start + (uint64_t) timer_period + 1;
+}
+
+static uint32_t timer_remaining(void)
+{
+  if (!timer_running)
+    return timer_period;
+  return timer_period - (uint32_t) (cycles - timer_start);
+}
+
+static void end_tick(void)
+{
+  uint64_t instr = instret - tick_instret;
+  uint64_t busy = (cycles - sleep_cycles) - tick_busy;
+  ticks++;
+  tick_instr_sum += instr;
+  tick_cycles_sum += busy;
+  if (instr > tick_instr_max)
+    tick_instr_max = instr;
+  if (busy > tick_cycles_max)
+    tick_cycles_max = busy;
+  if (tick_csv)
+    fprintf(tick_csv, "%llu,%llu,%llu\n", (unsigned long long) cycles,
+            (unsigned long long) instr, (unsigned long long) busy);
+  tick_instret = instret;
+  tick_busy = cycles - sleep_cycles;
+}
+
+/* The earliest cycle something happens on its own */
+static uint64_t next_event(void)
+{
+  uint64_t next = next_vsync;
+  if (timer_running && timer_expiry() < next)
+    next = timer_expiry();
+  if (script_pos < script_count && script[script_pos].cycle < next)
+    next = script[script_pos].cycle;
+  return next;
+}
+
+/* Brings the devices up to the current cycle */
+static void run_devices(void)
+{
+  while (timer_running && cycles >= timer_expiry()) {
+    timer_timeout = 1;
+    end_tick();
+    if (timer_control & 0x2) { // CONT
+      timer_start = timer_expiry();
+    } else {
+      timer_running = 0;
+    }
+  }
+  while (cycles >= next_vsync) {
+    if (vga_swap_requested) {
+      uint32_t front = vga_front;
+      vga_front = vga_back;
+      vga_back = front;
+      vga_swap_requested = 0;
+    }
+    next_vsync += VSYNC_CYCLES;
+  }
+  while (script_pos < script_count && cycles >= script[script_pos].cycle) {
+    ScriptEvent *ev = &script[script_pos++];
+    switch (ev->kind) {
+    case EV_SWITCHES:
+      switch_edge |= (switches ^ ev->value) & 0x3ff;
+      switches = ev->value & 0x3ff;
+      break;
+    case EV_BUTTONS:
+      button_edge |= ev->value & ~buttons;
+      buttons = ev->value;
+      break;
+    case EV_PPM:
+      write_ppm(ev->file);
+      break;
+    case EV_END:
+      finished = 1;
+      break;
+    }
+  }
+}
+
+static uint32_t pending_irqs(void)
+{
+  uint32_t pending = 0;
+  if (timer_timeout && (timer_control & 0x1))
+    pending |= 1u << CAUSE_TIMER;
+  if (switch_edge & switch_mask)
+    pending |= 1u << CAUSE_SWITCH;
+  if (button_edge & button_mask)
+    pending |= 1u << CAUSE_BUTTON;
+  return pending;
+}
+
+/* ---- memory and devices ---- */
+
+static uint32_t io_read(uint32_t addr)
+{
+  switch (addr - IO_BASE) {
+  case 0x00: return leds;
+  case 0x10: return switches;
+  case 0x18: return switch_mask;
+  case 0x1c: return switch_edge;
+  case 0x20: return timer_timeout | (timer_running << 1);
+  case 0x24: return timer_control;
+  case 0x28: return timer_period & 0xffff;
+  case 0x2c: return timer_period >> 16;
+  case 0x30: return timer_snapshot & 0xffff;
+  case 0x34: return timer_snapshot >> 16;
+  case 0x40: return 0;               // nothing to read, RVALID clear
+  case 0x44: return 64u << 16;       // the host takes every byte at once
+  case 0xd0: return buttons;
+  case 0xd8: return button_mask;
+  case 0xdc: return button_edge;
+  case 0x100: return vga_front;
+  case 0x104: return vga_back;
+  case 0x108: return VGA_WIDTH | (VGA_HEIGHT << 16);
+  case 0x10c: return vga_swap_requested;
+  }
+  if (addr - IO_BASE >= 0x50 && addr - IO_BASE < 0xb0 && ((addr - IO_BASE) & 0xf) == 0)
+    return segments[(addr - IO_BASE - 0x50) >> 4];
+  return 0;
+}
+
+static void io_write(uint32_t addr, uint32_t value)
+{
+  switch (addr - IO_BASE) {
+  case 0x00: leds = value & 0x3ff; return;
+  case 0x18: switch_mask = value & 0x3ff; return;
+  case 0x1c: switch_edge = 0; return;      // any write clears it
+  case 0x20: timer_timeout = 0; return;
+  case 0x24:
+    devices_due = 0; // the timer may expire earlier now
+    timer_control = value & 0x3;
+    if (value & 0x8) // STOP
+      timer_running = 0;
+    if (value & 0x4) { // START, from the period
+      timer_running = 1;
+      timer_start = cycles;
+    }
+    return;
+  case 0x28: timer_period = (timer_period & 0xffff0000u) | (value & 0xffff); timer_running = 0; return;
+  case 0x2c: timer_period = (timer_period & 0xffff) | (value << 16); timer_running = 0; return;
+  case 0x30: case 0x34: timer_snapshot = timer_remaining(); return;
+  case 0x40:
+    uart_bytes++;
+    if (!quiet)
+      putchar(value & 0xff);
+    return;
+  case 0xd8: button_mask = value; return;
+  case 0xdc: button_edge = 0; return;
+  case 0x100: vga_swap_requested = 1; return;
+  case 0x104: vga_back = value; return;
+  }
+  if (addr - IO_BASE >= 0x50 && addr - IO_BASE < 0xb0 && ((addr - IO_BASE) & 0xf) == 0)
+    segments[(addr - IO_BASE - 0x50) >> 4] = value;
+}
+
+/* Pointer to size bytes at addr in RAM or VGA memory, 0 for anything else */
+static uint8_t *memory(uint32_t addr, int size)
+{
+  if (addr < RAM_SIZE && addr + size <= RAM_SIZE)
+    return ram + addr;
+  if (addr >= VGA_BASE && addr - VGA_BASE + size <= VGA_BYTES)
+    return vga + (addr - VGA_BASE);
+  return 0;
+}
+
+static int is_io(uint32_t addr)
+{
+  return addr >= IO_BASE && addr < IO_BASE + IO_SIZE;
+}
+
+/* ---- traps ---- */
+
+static void trap(uint32_t cause, uint32_t value)
+{
+  uint32_t base = mtvec & ~3u;
+  mepc = pc;
+  mcause = cause;
+  mtval = value;
+  saved_irq_bits = mstatus & MSTATUS_IRQ_BITS;
+  mstatus = (mstatus & ~(MSTATUS_IRQ_BITS | 0x80)) | (saved_irq_bits ? 0x80 : 0) | 0x1800; // MPIE, MPP
+  if ((cause & 0x80000000u) && (mtvec & 3) == 1)
+    pc = base + 4 * (cause & 0x7fffffff);
+  else
+    pc = base;
+  cycles += CYCLES_TRAP;
+  if (!(cause & 0x80000000u))
+    exceptions++;
+}
+
+static void mret(void)
+{
+  mstatus = (mstatus & ~(MSTATUS_IRQ_BITS | 0x80)) | saved_irq_bits | 0x80;
+  pc = mepc;
+  cycles += CYCLES_TRAP;
+}
+
+static int csr_access(uint32_t csr, uint32_t *value, uint32_t write, int op)
+{
+  uint32_t *reg = 0;
+  uint32_t old;
+  switch (csr) {
+  case 0x300: reg = &mstatus; break;
+  case 0x304: reg = &mie; break;
+  case 0x305: reg = &mtvec; break;
+  case 0x340: reg = &mscratch; break;
+  case 0x341: reg = &mepc; break;
+  case 0x342: reg = &mcause; break;
+  case 0x343: reg = &mtval; break;
+  case 0x301: old = 0x40001100; goto read_only; // misa: RV32IM
+  case 0x344: old = pending_irqs(); goto read_only;
+  case 0xb00: case 0xc00: old = (uint32_t) cycles; goto read_only;
+  case 0xb80: case 0xc80: old = (uint32_t) (cycles >> 32); goto read_only;
+  case 0xb02: case 0xc02: old = (uint32_t) instret; goto read_only;
+  case 0xb82: case 0xc82: old = (uint32_t) (instret >> 32); goto read_only;
+  case 0xb03: case 0xc03: old = 0; goto read_only; // mhpmcounter3 is not modelled
+  case 0xf14: old = 0; goto read_only;             // mhartid
+  default: return 0;
+  }
+  old = *reg;
+  if (op == 1)
+    *reg = write;
+  else if (op == 2)
+    *reg = old | write;
+  else
+    *reg = old & ~write;
+  *value = old;
+  return 1;
+read_only:
+  *value = old; // writes to the counters are ignored
+  return 1;
+}
+
+/* ---- the core ---- */
+
+static uint32_t load(uint32_t addr, int size, int is_signed, int *fault)
+{
+  uint32_t v;
+  if (is_io(addr)) {
+    cycles += CYCLES_IO;
+    v = io_read(addr & ~3u) >> (8 * (addr & 3));
+  } else {
+    uint8_t *p = memory(addr, size);
+    if (!p) {
+      *fault = 1;
+      return 0;
+    }
+    v = p[0];
+    if (size > 1)
+      v |= p[1] << 8;
+    if (size > 2)
+      v |= (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+  }
+  if (size == 1)
+    v = is_signed ? (uint32_t) (int8_t) v : (v & 0xff);
+  else if (size == 2)
+    v = is_signed ? (uint32_t) (int16_t) v : (v & 0xffff);
+  return v;
+}
+
+static int store(uint32_t addr, uint32_t v, int size)
+{
+  if (is_io(addr)) {
+    cycles += CYCLES_IO;
+    io_write(addr & ~3u, v);
+    return 1;
+  }
+  uint8_t *p = memory(addr, size);
+  if (!p)
+    return 0;
+  p[0] = v;
+  if (size > 1)
+    p[1] = v >> 8;
+  if (size > 2) {
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+  }
+  return 1;
+}
+
+static int32_t imm_i(uint32_t in) { return (int32_t) in >> 20; }
+static int32_t imm_s(uint32_t in) { return ((int32_t) in >> 25 << 5) | ((in >> 7) & 0x1f); }
+static int32_t imm_b(uint32_t in)
+{
+  return ((int32_t) in >> 31 << 12) | ((in << 4) & 0x800) | ((in >> 20) & 0x7e0) | ((in >> 7) & 0x1e);
+}
+static int32_t imm_j(uint32_t in)
+{
+  return ((int32_t) in >> 31 << 20) | (in & 0xff000) | ((in >> 9) & 0x800) | ((in >> 20) & 0x7fe);
+}
+
+/* RV32M, also the extra cycles */
+static uint32_t muldiv(int funct3, uint32_t a, uint32_t b)
+{
+  int32_t sa = (int32_t) a, sb = (int32_t) b;
+  cycles += funct3 < 4 ? CYCLES_MUL : CYCLES_DIV;
+  switch (funct3) {
+  case 0: return a * b;
+  case 1: return (uint32_t) (((int64_t) sa * sb) >> 32);
+  case 2: return (uint32_t) (((int64_t) sa * (uint64_t) b) >> 32);
+  case 3: return (uint32_t) (((uint64_t) a * b) >> 32);
+  case 4: return b == 0 ? 0xffffffffu : (sa == INT32_MIN && sb == -1) ? a : (uint32_t) (sa / sb);
+  case 5: return b == 0 ? 0xffffffffu : a / b;
+  case 6: return b == 0 ? a : (sa == INT32_MIN && sb == -1) ? 0 : (uint32_t) (sa % sb);
+  default: return b == 0 ? a : a % b;
+  }
+}
+
+/* Runs one instruction, or takes an interrupt */
+static void step(void)
+{
+  uint32_t pending = pending_irqs();
+  if (pending && (mstatus & MSTATUS_IRQ_BITS)) {
+    int cause = CAUSE_TIMER;
+    while (!(pending & (1u << cause)))
+      cause++;
+    trap(0x80000000u | cause, 0);
+    return;
+  }
+
+  uint8_t *p = memory(pc, 4);
+  if (!p || (pc & 3)) {
+    trap(1, pc); // instruction access fault
+    return;
+  }
+  uint32_t in = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+  uint32_t rd = (in >> 7) & 0x1f, rs1 = (in >> 15) & 0x1f, rs2 = (in >> 20) & 0x1f;
+  uint32_t funct3 = (in >> 12) & 7, funct7 = in >> 25;
+  uint32_t a = x[rs1], b = x[rs2];
+  uint32_t next = pc + 4;
+  uint32_t result = 0;
+  int write = 1;
+  int fault = 0;
+
+  cycles++;
+  switch (in & 0x7f) {
+  case 0x37: result = in & 0xfffff000u; break;                  // lui
+  case 0x17: result = pc + (in & 0xfffff000u); break;           // auipc
+  case 0x6f:                                                    // jal
+    result = next;
+    next = pc + imm_j(in);
+    cycles += CYCLES_TAKEN;
+    break;
+  case 0x67:                                                    // jalr
+    result = next;
+    next = (a + imm_i(in)) & ~1u;
+    cycles += CYCLES_TAKEN;
+    break;
+  case 0x63: {                                                  // branches
+    int taken;
+    write = 0;
+    switch (funct3) {
+    case 0: taken = a == b; break;
+    case 1: taken = a != b; break;
+    case 4: taken = (int32_t) a < (int32_t) b; break;
+    case 5: taken = (int32_t) a >= (int32_t) b; break;
+    case 6: taken = a < b; break;
+    case 7: taken = a >= b; break;
+    default: trap(2, in); return;
+    }
+    if (taken) {
+      next = pc + imm_b(in);
+      cycles += CYCLES_TAKEN;
+    }
+    break;
+  }
+  case 0x03: {                                                  // loads
+    uint32_t addr = a + imm_i(in);
+    cycles += CYCLES_LOAD;
+    switch (funct3) {
+    case 0: result = load(addr, 1, 1, &fault); break;
+    case 1: result = load(addr, 2, 1, &fault); break;
+    case 2: result = load(addr, 4, 0, &fault); break;
+    case 4: result = load(addr, 1, 0, &fault); break;
+    case 5: result = load(addr, 2, 0, &fault); break;
+    default: trap(2, in); return;
+    }
+    if (fault) {
+      trap(5, addr);
+      return;
+    }
+    break;
+  }
+  case 0x23: {                                                  // stores
+    uint32_t addr = a + imm_s(in);
+    write = 0;
+    if (funct3 > 2) {
+      trap(2, in);
+      return;
+    }
+    if (!store(addr, b, 1 << funct3)) {
+      trap(7, addr);
+      return;
+    }
+    break;
+  }
+  case 0x13: {                                                  // immediate ops
+    int32_t imm = imm_i(in);
+    uint32_t shamt = rs2;
+    switch (funct3) {
+    case 0: result = a + imm; break;
+    case 1: result = a << shamt; break;
+    case 2: result = (int32_t) a < imm; break;
+    case 3: result = a < (uint32_t) imm; break;
+    case 4: result = a ^ imm; break;
+    case 5: result = (funct7 & 0x20) ? (uint32_t) ((int32_t) a >> shamt) : a >> shamt; break;
+    case 6: result = a | imm; break;
+    case 7: result = a & imm; break;
+    }
+    break;
+  }
+  case 0x33:                                                    // register ops
+    if (funct7 == 1) {
+      result = muldiv(funct3, a, b);
+      break;
+    }
+    switch (funct3) {
+    case 0: result = (funct7 & 0x20) ? a - b : a + b; break;
+    case 1: result = a << (b & 31); break;
+    case 2: result = (int32_t) a < (int32_t) b; break;
+    case 3: result = a < b; break;
+    case 4: result = a ^ b; break;
+    case 5: result = (funct7 & 0x20) ? (uint32_t) ((int32_t) a >> (b & 31)) : a >> (b & 31); break;
+    case 6: result = a | b; break;
+    case 7: result = a & b; break;
+    }
+    break;
+  case 0x0f: write = 0; break;                                  // fence
+  case 0x73:                                                    // system
+    if (funct3 == 0) {
+      write = 0;
+      if (in == 0x00000073) {                                   // ecall
+        trap(11, 0);
+        return;
+      } else if (in == 0x00100073) {                            // ebreak
+        trap(3, pc);
+        return;
+      } else if (in == 0x30200073) {                            // mret
+        mret();
+        instret++;
+        return;
+      } else if (in == 0x10500073) {                            // wfi
+        if (!pending_irqs()) {
+          uint64_t wake = next_event();
+          if (wake > cycles) {
+            sleep_cycles += wake - cycles;
+            cycles = wake;
+          }
+        }
+      } else {
+        trap(2, in);
+        return;
+      }
+    } else {
+      uint32_t source = (funct3 & 4) ? rs1 : a;
+      int op = funct3 & 3;
+      // csrrs and csrrc with x0 only read
+      if (!csr_access(in >> 20, &result, source, (op != 1 && rs1 == 0) ? 2 : op)) {
+        trap(2, in);
+        return;
+      }
+    }
+    break;
+  default:
+    trap(2, in);
+    return;
+  }
+  if (write && rd != 0)
+    x[rd] = result;
+  pc = next;
+  instret++;
+}
+
+/* ---- inputs and outputs ---- */
+
+static void write_ppm(const char *file)
+{
+  uint8_t *frame = memory(vga_front, VGA_BYTES);
+  FILE *out = fopen(file, "wb");
+  if (!out || !frame) {
+    fprintf(stderr, "cannot write %s\n", file);
+    if (out)
+      fclose(out);
+    return;
+  }
+  fprintf(out, "P6\n%d %d\n255\n", VGA_WIDTH, VGA_HEIGHT);
+  for (int i = 0; i < VGA_BYTES; i++) { // RGB 3-3-2
+    uint8_t c = frame[i];
+    uint8_t rgb[3] = {((c >> 5) & 7) * 255 / 7, ((c >> 2) & 7) * 255 / 7, (c & 3) * 255 / 3};
+    fwrite(rgb, 1, 3, out);
+  }
+  fclose(out);
+}
+
+static void read_script(const char *file)
+{
+  FILE *in = fopen(file, "r");
+  char line[256];
+  int capacity = 0;
+  if (!in) {
+    perror(file);
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), in)) {
+    double ms;
+    char what[16];
+    char arg[128] = "";
+    if (line[0] == '#' || sscanf(line, "%lf %15s %127s", &ms, what, arg) < 2)
+      continue;
+    if (script_count == capacity) {
+      capacity = capacity ? 2 * capacity : 16;
+      script = realloc(script, capacity * sizeof(*script));
+    }
+    ScriptEvent *ev = &script[script_count++];
+    ev->cycle = (uint64_t) (ms * CYCLES_PER_MS);
+    ev->value = (int) strtol(arg, 0, 0);
+    if (strcmp(what, "sw") == 0) {
+      ev->kind = EV_SWITCHES;
+    } else if (strcmp(what, "btn") == 0) {
+      ev->kind = EV_BUTTONS;
+    } else if (strcmp(what, "ppm") == 0) {
+      ev->kind = EV_PPM;
+      snprintf(ev->file, sizeof(ev->file), "%s", arg);
+    } else if (strcmp(what, "end") == 0) {
+      ev->kind = EV_END;
+    } else {
+      fprintf(stderr, "%s: unknown input %s\n", file, what);
+      exit(1);
+    }
+    if (script_count > 1 && ev->cycle < script[script_count - 2].cycle) {
+      fprintf(stderr, "%s: inputs must be in order of time\n", file);
+      exit(1);
+    }
+  }
+  fclose(in);
+}
+
+static void load_binary(const char *file)
+{
+  FILE *in = fopen(file, "rb");
+  if (!in) {
+    perror(file);
+    exit(1);
+  }
+  size_t n = fread(ram, 1, RAM_SIZE, in);
+  fclose(in);
+  if (n == 0) {
+    fprintf(stderr, "%s is empty\n", file);
+    exit(1);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  double limit_ms = 10000;
+  const char *ppm = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "qt:s:o:T:")) != -1) {
+    switch (opt) {
+    case 'q': quiet = 1; break;
+    case 't': limit_ms = atof(optarg); break;
+    case 's': read_script(optarg); break;
+    case 'o': ppm = optarg; break;
+    case 'T':
+      tick_csv = fopen(optarg, "w");
+      if (!tick_csv) {
+        perror(optarg);
+        return 1;
+      }
+      fprintf(tick_csv, "cycle,instructions,busy_cycles\n");
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-q] [-t ms] [-s script] [-o out.ppm] [-T ticks.csv] [main.bin]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  ram = calloc(RAM_SIZE, 1);
+  load_binary(optind < argc ? argv[optind] : "main.bin");
+  pc = RESET_PC;
+
+  uint64_t limit = (uint64_t) (limit_ms * CYCLES_PER_MS);
+  while (!finished && cycles < limit) {
+    step();
+    if (cycles >= devices_due) {
+      run_devices();
+      devices_due = next_event();
+    }
+  }
+  fflush(stdout);
+
+  if (ppm)
+    write_ppm(ppm);
+  if (tick_csv)
+    fclose(tick_csv);
+
+  double seconds = (double) cycles / CLOCK_HZ;
+  fprintf(stderr, "\n%.3f s modelled: %llu instructions, %llu cycles, %.1f%% asleep in wfi\n",
+          seconds, (unsigned long long) instret, (unsigned long long) cycles,
+          cycles ? 100.0 * sleep_cycles / cycles : 0.0);
+  if (ticks > 0)
+    fprintf(stderr, "%llu ticks: %.0f instructions and %.0f busy cycles per tick, worst %llu and %llu\n",
+            (unsigned long long) ticks, (double) tick_instr_sum / ticks, (double) tick_cycles_sum / ticks,
+            (unsigned long long) tick_instr_max, (unsigned long long) tick_cycles_max);
+  fprintf(stderr, "leds %03x, displays %02x %02x %02x %02x %02x %02x, %llu bytes over JTAG, %llu exceptions\n",
+          leds, segments[5] & 0xff, segments[4] & 0xff, segments[3] & 0xff, segments[2] & 0xff,
+          segments[1] & 0xff, segments[0] & 0xff, (unsigned long long) uart_bytes,
+          (unsigned long long) exceptions);
+  return 0;
+}
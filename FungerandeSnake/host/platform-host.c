@@ -0,0 +1,198 @@
+/* platform-host.c
+
+   Host backend for platform.h, used when the game is built natively
+   with -DPLATFORM_HOST. The registers become plain variables:
+
+   - the VGA pages are memory and a swap happens immediately
+   - the timer counts virtual cycles that only move when the program
+     calls host_advance, raising interrupt 16 like the real timer
+   - the switches follow a script of (cycle, value) events and raise
+     interrupt 17 on a change, like the edge capture register
+   - host_set_buttons raises interrupt 18 on a press
+   - waiting for an interrupt jumps the clock to the next event
+   - the JTAG UART writes to stdout unless host_set_quiet was called */
+
+#include <stdio.h>
+#include <time.h>
+#include "platform.h"
+#include "vga.h"
+
+unsigned char host_vga[VGA_FRAME_BYTES] __attribute__((aligned(4)));
+
+static uintptr_t vga_front;
+static uintptr_t vga_back;
+
+static void (*irq_handler)(unsigned cause);
+static unsigned long long now;
+
+static unsigned int timer_period;
+static unsigned long long timer_next; // cycle of the next timeout
+static int timer_running;
+
+static const HostSwitchEvent *script;
+static int script_count;
+static int script_pos;
+static int switches;
+static int switch_irq_mask;
+static int switch_edges;
+static int buttons;
+static int button_irq_mask;
+static int leds;
+static int segments[6];
+static int quiet;
+
+void plat_leds(int mask) { leds = mask; }
+int plat_switches(void) { return switches; }
+void plat_switch_irq_enable(int mask) { switch_irq_mask = mask; }
+void plat_switch_irq_ack(void) { switch_edges = 0; }
+int plat_buttons(void) { return buttons; }
+void plat_button_irq_enable(int mask) { button_irq_mask = mask; }
+void plat_button_irq_ack(void) {}
+
+void plat_segments(int display, int pattern)
+{
+  if (display >= 0 && display < 6)
+    segments[display] = pattern;
+}
+
+void plat_timer_start(unsigned int period_cycles)
+{
+  timer_period = period_cycles + 1; // the counter runs from period down to 0
+  timer_next = now + timer_period;
+  timer_running = 1;
+}
+
+void plat_timer_ack(void) {}
+int plat_timer_timed_out(void) { return 0; }
+
+unsigned int plat_timer_remaining(void)
+{
+  return timer_next > now ? (unsigned int) (timer_next - now - 1) : 0;
+}
+
+/* The probes measure real time on the host, not virtual cycles */
+unsigned int plat_cycles(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned int) (ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+unsigned int plat_instret(void) { return 0; }
+unsigned int plat_hpm3(void) { return 0; }
+
+int plat_jtag_space(void) { return 1; }
+
+void plat_jtag_write(char c)
+{
+  if (!quiet)
+    putchar(c);
+}
+
+static uintptr_t front(void) { return vga_front ? vga_front : VGA_BASE; }
+static uintptr_t back(void) { return vga_back ? vga_back : VGA_BASE; }
+
+uintptr_t plat_vga_frontbuffer(void) { return front(); }
+uintptr_t plat_vga_backbuffer(void) { return back(); }
+void plat_vga_set_backbuffer(uintptr_t addr) { vga_back = addr; }
+
+void plat_vga_swap(void)
+{
+  uintptr_t shown = front();
+  vga_front = back();
+  vga_back = shown;
+}
+
+int plat_vga_swap_pending(void) { return 0; }
+
+unsigned int plat_irq_save(void) { return 0; }
+void plat_irq_restore(unsigned int old) { (void) old; }
+void plat_irq_unmask(int cause) { (void) cause; }
+
+/**
+ * @arg handler, called with the interrupt cause like handle_interrupt
+ */
+void host_set_irq_handler(void (*handler)(unsigned cause))
+{
+  irq_handler = handler;
+}
+
+/**
+ * @arg events, switch values to apply, sorted by cycle
+ * @arg count, number of events
+ * The array is used in place and must outlive the run
+ */
+void host_script_switches(const HostSwitchEvent *events, int count)
+{
+  script = events;
+  script_count = count;
+  script_pos = 0;
+}
+
+static void raise(unsigned cause)
+{
+  if (irq_handler)
+    irq_handler(cause);
+}
+
+void host_set_buttons(int value)
+{
+  int pressed = value & ~buttons;
+  buttons = value;
+  if (pressed & button_irq_mask)
+    raise(18);
+}
+
+/**
+ * @arg cycles, how far to move the virtual clock
+ * Fires every timer timeout and scripted switch change in the interval,
+ * in order, through the interrupt handler
+ */
+void host_advance(unsigned long long cycles)
+{
+  unsigned long long end = now + cycles;
+  for (;;) {
+    int switch_due = script_pos < script_count && script[script_pos].cycle <= end;
+    int timer_due = timer_running && timer_next <= end;
+    if (!switch_due && !timer_due)
+      break;
+
+    if (switch_due && (!timer_due || script[script_pos].cycle <= timer_next)) {
+      int changed = switches ^ script[script_pos].switches;
+      if (script[script_pos].cycle > now)
+        now = script[script_pos].cycle;
+      switches = script[script_pos].switches;
+      script_pos++;
+      switch_edges |= changed & switch_irq_mask;
+      if (switch_edges)
+        raise(17);
+    } else {
+      now = timer_next;
+      timer_next += timer_period;
+      raise(16);
+    }
+  }
+  now = end;
+}
+
+/* Nothing happens between events, so sleeping skips straight to the next */
+void plat_wait_for_interrupt(void)
+{
+  unsigned long long next = 0;
+  int found = 0;
+  if (timer_running) {
+    next = timer_next;
+    found = 1;
+  }
+  if (script_pos < script_count && (!found || script[script_pos].cycle < next)) {
+    next = script[script_pos].cycle;
+    found = 1;
+  }
+  if (found)
+    host_advance(next > now ? next - now : 0);
+}
+
+unsigned long long host_cycles(void) { return now; }
+
+uintptr_t host_vga_front(void) { return front(); }
+
+void host_set_quiet(int value) { quiet = value; }
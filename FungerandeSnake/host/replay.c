@@ -0,0 +1,167 @@
+/* replay.c
+
+   Replays logs made by record.c on the host, built with make replay.
+   The log is read from the "REC" lines the board prints over JTAG when
+   built with -DRECORD, so the output of dtekv-run can be piped in as
+   it is. The game runs without any timer, drawing every move into the
+   host framebuffer, and the time per move is reported.
+
+   Usage: snake-replay [-c] < log      replay, or -c to print the log
+                                       as C for replay-log.h
+          snake-replay -r [seed]       play a game with random turns
+                                       and print its log
+          snake-replay -a              let the autopilot play a game
+                                       and print its log */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "platform.h"
+#include "snake.h"
+#include "render.h"
+#include "record.h"
+#include "autopilot.h"
+#include "vga.h"
+#include "dtekv-lib.h"
+
+static unsigned char log_bytes[RECORD_MAX_BYTES];
+
+static unsigned long long now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Collects the hex bytes after "REC " on each line, other lines are skipped */
+static int read_log(FILE *in)
+{
+  char line[256];
+  int n = 0;
+  while (fgets(line, sizeof(line), in)) {
+    char *p = strstr(line, "REC ");
+    if (!p)
+      continue;
+    unsigned int byte;
+    for (p += 4; n < RECORD_MAX_BYTES && sscanf(p, "%2x", &byte) == 1; p += 2)
+      log_bytes[n++] = byte;
+  }
+  return n;
+}
+
+/* The switches of the game as runGame sees them: bit 0 right, bit 1 left */
+static void apply_switches(Snake *snake, int switches)
+{
+  snake->right = switches & 1;
+  snake->left = (switches >> 1) & 1;
+}
+
+static int replay(int bytes)
+{
+  static Board board;
+  static Snake snake;
+  unsigned int moves = 0;
+
+  if (!replay_load(log_bytes, bytes)) {
+    fprintf(stderr, "not a log for BOARD_SIZE %d\n", BOARD_SIZE);
+    return 1;
+  }
+  vga_init();
+  startgame(&snake, &board);
+  invalidate_board();
+  apply_switches(&snake, replay_initial_switches());
+
+  unsigned long long t0 = now_ns();
+  while (snake.snake_playing) {
+    apply_switches(&snake, replay_switches(moves));
+    changeDirectionSnake(&snake, snake.right, snake.left);
+    moveSnake(&snake, &board);
+    moves++;
+    render_dirty(&board, &snake);
+    vga_present();
+  }
+  unsigned long long ns = now_ns() - t0;
+
+  int result = replay_finish(moves, snake.length);
+  printf("%s: %u moves, length %d, %.1f ns/move\n",
+         result == REPLAY_MATCHES ? "replay matches"
+         : result == REPLAY_TRUNCATED ? "log truncated, not compared" : "REPLAY DIFFERS",
+         moves, snake.length, moves ? (double) ns / moves : 0.0);
+  return result; // 0 only for a match
+}
+
+static Autopilot pilot;
+
+/* Plays one game turning at random, away from walls and the body when
+   it can, or steered by the autopilot, and prints its log like the
+   board does */
+static void record(unsigned int rng, bool autopilot)
+{
+  static Board board;
+  static Snake snake;
+  static const int drow[4] = {-1, 0, 1, 0};
+  static const int dcol[4] = {0, 1, 0, -1};
+  unsigned int moves = 0;
+  int switches = 0;
+
+  record_begin(random_get_state(), switches);
+  startgame(&snake, &board);
+  autopilot_init(&pilot);
+  while (snake.snake_playing && autopilot) {
+    record_switches(moves, autopilot_steer(&pilot, &snake, &board));
+    changeDirectionSnake(&snake, snake.right, snake.left);
+    moveSnake(&snake, &board);
+    moves++;
+  }
+  while (snake.snake_playing) {
+    int first = rand_r(&rng) % 8 == 0 ? 1 + rand_r(&rng) % 2 : switches;
+    for (int i = 0; i < 3; i++) {
+      int candidate = (first + i) % 3; // 0 straight, 1 right, 2 left
+      Position head = snake.head;
+      int d = calculateDirectionChange(candidate & 1, candidate >> 1, snake.direction);
+      int row = head.row + drow[d];
+      int col = head.col + dcol[d];
+      if (row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE && !board_is_snake(&board, row, col)) {
+        switches = candidate;
+        break;
+      }
+    }
+    record_switches(moves, switches);
+    apply_switches(&snake, switches);
+    changeDirectionSnake(&snake, snake.right, snake.left);
+    moveSnake(&snake, &board);
+    moves++;
+  }
+  const unsigned char *log;
+  record_end(moves, snake.length, &log);
+  while (print_drain() != 0); // the game over messages, still quiet
+  host_set_quiet(0);
+  record_dump();
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int tmp = 1234567890;
+
+  host_set_quiet(1); // the game over messages
+  seed = random_value(&tmp);
+
+  if (argc > 1 && strcmp(argv[1], "-r") == 0) {
+    record(argc > 2 ? strtoul(argv[2], 0, 0) : 1, false);
+    return 0;
+  }
+  if (argc > 1 && strcmp(argv[1], "-a") == 0) {
+    record(0, true);
+    return 0;
+  }
+
+  int bytes = read_log(stdin);
+  if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+    for (int i = 0; i < bytes; i++)
+      printf("0x%02x,%c", log_bytes[i], i % 12 == 11 ? '\n' : ' ');
+    printf("\n");
+    return 0;
+  }
+  return replay(bytes);
+}
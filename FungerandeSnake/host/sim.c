@@ -0,0 +1,310 @@
+/* sim.c
+
+   Headless batch simulator, built with make sim. Plays many games of
+   the game core (snake.c, board.c, freecells.c, score.c and
+   autopilot.c) without VGA, timer or any other device, on a pool of
+   threads, and reports games per second and how long the snakes got.
+
+   Each worker thread owns a range of game numbers and plays them one
+   at a time. A worker that runs out steals half of what is left of
+   another worker's range, so long games do not leave threads idle.
+   Game n always starts from the same random state whatever thread
+   plays it, so the results do not depend on the number of threads.
+
+   The state the core keeps outside of Snake and Board is per thread
+   here (GAME_LOCAL in board.h), and the hardware calls of the core
+   are the stubs at the end of this file.
+
+   Usage: snake-sim [-n games] [-t threads] [-a] [-s seed] [-x]
+     -a  the autopilot steers instead of random turns
+     -x  run with 1, 2, 4 .. threads to show the scaling */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "snake.h"
+#include "autopilot.h"
+
+#define CELLS (BOARD_SIZE * BOARD_SIZE)
+#define CHUNK 16                   // games a worker takes from its range at a time
+#define RANDOM_MOVE_LIMIT (64 * CELLS) // random turns can circle forever
+
+typedef struct {
+  long games;
+  long wins;
+  long timeouts; // games stopped at RANDOM_MOVE_LIMIT
+  long moves;
+  long steals;
+  long lengths[CELLS + 1]; // games that ended at each length
+} Stats;
+
+typedef struct {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  long next; // the games [next, end) are still to be played
+  long end;
+  Board board;
+  Snake snake;
+  Autopilot *pilot;
+  Stats stats;
+} Worker;
+
+static Worker *workers;
+static int worker_count;
+static bool use_autopilot;
+static unsigned int base_seed = 1234567890;
+
+static double now_s(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Spreads the game numbers over the random states */
+static unsigned int game_seed(long game)
+{
+  unsigned int x = base_seed ^ (unsigned int) game * 0x9E3779B9u;
+  x ^= x >> 16;
+  x *= 0x85EBCA6Bu;
+  x ^= x >> 13;
+  return x;
+}
+
+static bool safe(Snake *snake, Board *board, int direction)
+{
+  static const int drow[4] = {-1, 0, 1, 0};
+  static const int dcol[4] = {0, 1, 0, -1};
+  Position head = snake->head;
+  int row = head.row + drow[direction];
+  int col = head.col + dcol[direction];
+  return row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE && !board_is_snake(board, row, col);
+}
+
+/* Turns now and then, away from walls and the body when it can */
+static void steer_random(Snake *snake, Board *board, unsigned int *rng)
+{
+  static const bool options[3][2] = {{true, true}, {true, false}, {false, true}}; // straight, right, left
+  int first = (rand_r(rng) % 4 == 0) ? 1 + rand_r(rng) % 2 : 0;
+  for (int i = 0; i < 3; i++) {
+    const bool *turn = options[(first + i) % 3];
+    if (safe(snake, board, calculateDirectionChange(turn[0], turn[1], snake->direction))) {
+      snake->right = turn[0];
+      snake->left = turn[1];
+      return;
+    }
+  }
+  snake->right = snake->left = true;
+}
+
+static void play(Worker *w, long game)
+{
+  unsigned int rng = game_seed(game);
+  long moves = 0;
+
+  random_set_state(rng);
+  startgame(&w->snake, &w->board);
+  if (use_autopilot)
+    autopilot_reset(w->pilot);
+  while (w->snake.snake_playing) {
+    if (use_autopilot) {
+      autopilot_steer(w->pilot, &w->snake, &w->board);
+    } else if (moves == RANDOM_MOVE_LIMIT) {
+      w->stats.timeouts++;
+      break;
+    } else {
+      steer_random(&w->snake, &w->board, &rng);
+    }
+    changeDirectionSnake(&w->snake, w->snake.right, w->snake.left);
+    moveSnake(&w->snake, &w->board);
+    moves++;
+  }
+  w->stats.games++;
+  w->stats.moves += moves;
+  w->stats.wins += w->snake.length >= CELLS;
+  w->stats.lengths[w->snake.length]++;
+}
+
+/* Takes up to CHUNK games from the front of the own range */
+static long take(Worker *w, long *first)
+{
+  pthread_mutex_lock(&w->lock);
+  long n = w->end - w->next;
+  if (n > CHUNK)
+    n = CHUNK;
+  *first = w->next;
+  w->next += n;
+  pthread_mutex_unlock(&w->lock);
+  return n;
+}
+
+/* Moves the back half of another worker's range to this one */
+static bool steal(Worker *w, unsigned int *rng)
+{
+  int start = rand_r(rng) % worker_count;
+  for (int i = 0; i < worker_count; i++) {
+    Worker *victim = &workers[(start + i) % worker_count];
+    if (victim == w)
+      continue;
+    pthread_mutex_lock(&victim->lock);
+    long left = victim->end - victim->next;
+    if (left > 0) {
+      long half = (left + 1) / 2;
+      victim->end -= half;
+      long first = victim->end;
+      pthread_mutex_unlock(&victim->lock);
+      pthread_mutex_lock(&w->lock);
+      w->next = first;
+      w->end = first + half;
+      pthread_mutex_unlock(&w->lock);
+      w->stats.steals++;
+      return true;
+    }
+    pthread_mutex_unlock(&victim->lock);
+  }
+  return false;
+}
+
+static void *work(void *arg)
+{
+  Worker *w = arg;
+  unsigned int rng = (unsigned int) (w - workers) + 1;
+  for (;;) {
+    long first;
+    long n = take(w, &first);
+    if (n == 0) {
+      if (!steal(w, &rng))
+        return NULL; // nothing left anywhere
+      continue;
+    }
+    for (long game = first; game < first + n; game++)
+      play(w, game);
+  }
+}
+
+/* Plays games 0 .. games-1 on threads workers and adds up their stats */
+static double run(long games, int threads, Stats *total)
+{
+  worker_count = threads;
+  workers = calloc(threads, sizeof(Worker));
+  for (int i = 0; i < threads; i++) {
+    Worker *w = &workers[i];
+    pthread_mutex_init(&w->lock, NULL);
+    w->next = games * i / threads;
+    w->end = games * (i + 1) / threads;
+    if (use_autopilot) {
+      w->pilot = malloc(sizeof(Autopilot));
+      autopilot_init(w->pilot);
+    }
+  }
+
+  double t0 = now_s();
+  for (int i = 0; i < threads; i++)
+    pthread_create(&workers[i].thread, NULL, work, &workers[i]);
+  for (int i = 0; i < threads; i++)
+    pthread_join(workers[i].thread, NULL);
+  double seconds = now_s() - t0;
+
+  memset(total, 0, sizeof(*total));
+  for (int i = 0; i < threads; i++) {
+    Stats *s = &workers[i].stats;
+    total->games += s->games;
+    total->wins += s->wins;
+    total->timeouts += s->timeouts;
+    total->moves += s->moves;
+    total->steals += s->steals;
+    for (int l = 0; l <= CELLS; l++)
+      total->lengths[l] += s->lengths[l];
+    free(workers[i].pilot);
+    pthread_mutex_destroy(&workers[i].lock);
+  }
+  free(workers);
+  return seconds;
+}
+
+/* The length that fraction p of the games ended below, p = 1 is the longest */
+static int percentile(const Stats *s, double p)
+{
+  long seen = 0;
+  int longest = 0;
+  for (int l = 0; l <= CELLS; l++) {
+    if (s->lengths[l] == 0)
+      continue;
+    seen += s->lengths[l];
+    longest = l;
+    if (p < 1 && seen > p * s->games)
+      return l;
+  }
+  return longest;
+}
+
+static void report(const Stats *s, double seconds, int threads)
+{
+  double sum = 0;
+  for (int l = 0; l <= CELLS; l++)
+    sum += (double) l * s->lengths[l];
+  printf("%ld games on %d threads in %.2f s: %.0f games/s, %.0f moves/s, %ld steals\n",
+         s->games, threads, seconds, s->games / seconds, s->moves / seconds, s->steals);
+  printf("length: mean %.2f, min %d, 10%% %d, median %d, 90%% %d, max %d\n",
+         sum / s->games, percentile(s, 0), percentile(s, 0.1), percentile(s, 0.5),
+         percentile(s, 0.9), percentile(s, 1));
+  printf("moves/game %.1f, won %ld, stopped at the %d move limit %ld\n",
+         (double) s->moves / s->games, s->wins, RANDOM_MOVE_LIMIT, s->timeouts);
+}
+
+int main(int argc, char **argv)
+{
+  static Stats total;
+  long games = 100000;
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  bool scaling = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:t:as:x")) != -1) {
+    switch (opt) {
+    case 'n': games = atol(optarg); break;
+    case 't': threads = atoi(optarg); break;
+    case 'a': use_autopilot = true; break;
+    case 's': base_seed = strtoul(optarg, NULL, 0); break;
+    case 'x': scaling = true; break;
+    default:
+      fprintf(stderr, "usage: %s [-n games] [-t threads] [-a] [-s seed] [-x]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (threads < 1)
+    threads = 1;
+
+  if (!scaling) {
+    double seconds = run(games, threads, &total);
+    report(&total, seconds, threads);
+    return 0;
+  }
+
+  // the same games are played every time, so moves/game must not change
+  double base = 0;
+  for (int t = 1; ; t = t * 2 < threads ? t * 2 : threads) {
+    double seconds = run(games, t, &total);
+    double rate = total.games / seconds;
+    if (t == 1)
+      base = rate;
+    printf("%3d threads: %10.0f games/s, speedup %.2f, moves/game %.3f\n", t, rate, rate / base,
+           (double) total.moves / total.games);
+    if (t == threads)
+      break;
+  }
+  return 0;
+}
+
+/* The core without the hardware: nothing to draw, light or print */
+
+void print(char *s) { (void) s; }
+void print_dec(unsigned int x) { (void) x; }
+void set_leds(int mask) { (void) mask; }
+void set_displays_bcd(unsigned int bcd, bool point) { (void) bcd; (void) point; }
+void mark_dirty(int row, int col) { (void) row; (void) col; }
+unsigned int plat_cycles(void) { return 0; }
@@ -0,0 +1,192 @@
+/* hud.c
+
+   The HUD is one line of HUD_COLUMNS characters. hud_text and friends
+   change the wanted text, and hud_render draws the characters that
+   differ from what the page being drawn already shows, so a frame
+   where nothing changed draws nothing.
+
+   The font covers space to Z, 8x8 pixels with bit 0 as the leftmost
+   pixel. hud_init expands every glyph row into two words with 0xFF in
+   the bytes of the set pixels, so drawing a row is two masked word
+   stores (see vga_draw_mask). */
+
+#include <stdbool.h>
+#include "hud.h"
+
+#define FIRST_GLYPH ' '
+#define LAST_GLYPH 'Z'
+#define GLYPHS (LAST_GLYPH - FIRST_GLYPH + 1)
+
+#define HUD_Y (SCREEN_HEIGHT - HUD_HEIGHT)
+#define TEXT_Y (HUD_Y + (HUD_HEIGHT - 8) / 2)
+#define HUD_COLOR 0xFF
+#define HUD_BACKGROUND 0x00
+
+static const unsigned char font[GLYPHS][8] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // space
+  {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // !
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // " (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // # (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // $ (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // % (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // & (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ( (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ) (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // * (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // + (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // , (blank)
+  {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, // -
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // .
+  {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, // /
+  {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, // 0
+  {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, // 1
+  {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, // 2
+  {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, // 3
+  {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, // 4
+  {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, // 5
+  {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, // 6
+  {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, // 7
+  {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, // 8
+  {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, // 9
+  {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // :
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ; (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // < (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // = (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // > (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ? (blank)
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // @ (blank)
+  {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, // A
+  {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, // B
+  {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, // C
+  {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, // D
+  {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, // E
+  {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, // F
+  {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, // G
+  {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, // H
+  {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // I
+  {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, // J
+  {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, // K
+  {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, // L
+  {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, // M
+  {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, // N
+  {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, // O
+  {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, // P
+  {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, // Q
+  {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, // R
+  {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, // S
+  {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // T
+  {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, // U
+  {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // V
+  {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, // W
+  {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, // X
+  {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, // Y
+  {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, // Z
+};
+
+static unsigned int glyph_masks[GLYPHS][8][2];
+
+static char text[HUD_COLUMNS];        // what the HUD should show
+static char shown[2][HUD_COLUMNS];    // what each page shows, 0 when unknown
+static bool background_drawn[2];
+
+/* 0xFF in byte i of the result for bit i of the nibble */
+static unsigned int expand_nibble(unsigned int nibble)
+{
+  unsigned int mask = 0;
+  for (int bit = 0; bit < 4; bit++) {
+    if (nibble & (1 << bit)) {
+      mask |= 0xFFu << (8 * bit);
+    }
+  }
+  return mask;
+}
+
+/**
+ * Expands the font into word masks and clears the text, done once
+ */
+void hud_init(void)
+{
+  for (int g = 0; g < GLYPHS; g++) {
+    for (int row = 0; row < 8; row++) {
+      glyph_masks[g][row][0] = expand_nibble(font[g][row] & 0xF);
+      glyph_masks[g][row][1] = expand_nibble(font[g][row] >> 4);
+    }
+  }
+  for (int i = 0; i < HUD_COLUMNS; i++) {
+    text[i] = ' ';
+  }
+  hud_invalidate();
+}
+
+/**
+ * Makes the next hud_render of both pages draw the whole HUD
+ */
+void hud_invalidate(void)
+{
+  for (int page = 0; page < 2; page++) {
+    for (int i = 0; i < HUD_COLUMNS; i++) {
+      shown[page][i] = 0;
+    }
+    background_drawn[page] = false;
+  }
+}
+
+/**
+ * @arg column, the character position, 0 is the leftmost
+ * @arg s, the text, characters outside of space to Z show as space
+ */
+void hud_text(int column, const char *s)
+{
+  for (; *s != '\0' && column < HUD_COLUMNS; s++, column++) {
+    char c = *s;
+    text[column] = (c >= FIRST_GLYPH && c <= LAST_GLYPH) ? c : ' ';
+  }
+}
+
+/**
+ * @arg column, the position of the first digit
+ * @arg bcd, the number in BCD (see score.c)
+ * @arg digits, how many digits, with leading zeros
+ */
+void hud_bcd(int column, unsigned int bcd, int digits)
+{
+  for (int i = digits - 1; i >= 0 && column < HUD_COLUMNS; i--, column++) {
+    text[column] = '0' + ((bcd >> (4 * i)) & 0xF);
+  }
+}
+
+/**
+ * @arg column, the position of the first digit
+ * @arg value, the number
+ * @arg digits, how many digits, with leading spaces
+ * Divides by 10 for every digit, so it is only for the move interval,
+ * which changes with the length. The scores go through hud_bcd
+ */
+void hud_number(int column, unsigned int value, int digits)
+{
+  for (int i = column + digits - 1; i >= column; i--) {
+    if (i < HUD_COLUMNS) {
+      text[i] = (value != 0 || i == column + digits - 1) ? '0' + value % 10 : ' ';
+    }
+    value /= 10;
+  }
+}
+
+/**
+ * @arg page, the page being drawn, as returned by vga_begin_frame
+ * Brings the HUD on the page up to date with the text
+ */
+void hud_render(int page)
+{
+  if (!background_drawn[page]) {
+    vga_fill_rect(0, HUD_Y, SCREEN_WIDTH, HUD_HEIGHT, HUD_BACKGROUND);
+    background_drawn[page] = true;
+  }
+  for (int i = 0; i < HUD_COLUMNS; i++) {
+    if (shown[page][i] != text[i]) {
+      vga_draw_mask(8 * i, TEXT_Y, &glyph_masks[text[i] - FIRST_GLYPH][0][0], 8, HUD_COLOR, HUD_BACKGROUND);
+      shown[page][i] = text[i];
+    }
+  }
+}
@@ -0,0 +1,21 @@
+/* hud.h
+
+   Text line below the board: score, best score, speed and how the
+   game ended, drawn with an 8x8 font on the VGA output */
+
+#ifndef HUD_H
+#define HUD_H
+
+#include "vga.h"
+
+#define HUD_HEIGHT 16 // pixels below the board
+#define HUD_COLUMNS (SCREEN_WIDTH / 8)
+
+void hud_init(void);
+void hud_invalidate(void);
+void hud_text(int column, const char *text);
+void hud_bcd(int column, unsigned int bcd, int digits);
+void hud_number(int column, unsigned int value, int digits);
+void hud_render(int page);
+
+#endif /* HUD_H */
@@ -0,0 +1,195 @@
+/* input.c
+
+   Switch changes from the interrupt handler to the game loop, see
+   input.h.
+
+   head and tail count events forever and wrap together, the slot of
+   an event is its number modulo INPUT_QUEUE_SIZE. The interrupt only
+   writes head and the game loop only writes tail. There is one hart,
+   so a compiler barrier is enough to keep the event stores before the
+   store to head that publishes them.
+
+   When the game loop falls so far behind that the queue is full, the
+   new snapshot is not queued but kept as the latest one, and the game
+   loop gets it once it has caught up, so it always ends up with the
+   switches as they are. */
+
+#include "input.h"
+#include "platform.h"
+#include "dtekv-lib.h"
+
+#define barrier() asm volatile ("" : : : "memory")
+
+static InputEvent queue[INPUT_QUEUE_SIZE];
+static volatile unsigned int head; // events pushed, written by the interrupt
+static volatile unsigned int tail; // events popped, written by the game loop
+
+static volatile int latest_switches; // of the last event, also a dropped one
+static volatile unsigned int latest_time;
+static volatile unsigned int dropped;
+static unsigned int dropped_seen;
+
+// From a change reaching the game loop to the move that used it
+static bool waiting;
+static unsigned int waiting_since;
+static unsigned int latency_count;
+static unsigned int latency_sum_us;
+static unsigned int latency_max;
+
+/**
+ * @arg switches, the switches after the change
+ * @arg time, plat_cycles when it happened
+ * @return false if the queue was full
+ * Only called from the switch interrupt
+ */
+bool input_push(int switches, unsigned int time)
+{
+  unsigned int h = head;
+  latest_switches = switches;
+  latest_time = time;
+  if (h - tail == INPUT_QUEUE_SIZE) {
+    dropped++;
+    return false;
+  }
+  queue[h % INPUT_QUEUE_SIZE].switches = switches;
+  queue[h % INPUT_QUEUE_SIZE].time = time;
+  barrier(); // the event is written before it is published
+  head = h + 1;
+  return true;
+}
+
+/**
+ * @arg event, gets the oldest change not popped yet
+ * @return false if there is none
+ * Only called from the game loop
+ */
+bool input_pop(InputEvent *event)
+{
+  unsigned int t = tail;
+  if (t != head) {
+    barrier(); // the event is read after head said it is there
+    *event = queue[t % INPUT_QUEUE_SIZE];
+    barrier(); // and before the slot is given back
+    tail = t + 1;
+  } else if (dropped != dropped_seen) {
+    // changes were lost, the last one is what the switches are now
+    dropped_seen = dropped;
+    event->switches = latest_switches;
+    event->time = latest_time;
+  } else {
+    return false;
+  }
+  if (!waiting) {
+    waiting = true;
+    waiting_since = event->time;
+  }
+  return true;
+}
+
+/**
+ * @return true if input_pop has something
+ */
+bool input_pending(void)
+{
+  return tail != head || dropped != dropped_seen;
+}
+
+/**
+ * Forgets the changes not popped yet and the statistics, when a game
+ * starts and reads the switches itself
+ */
+void input_clear(void)
+{
+  tail = head;
+  dropped_seen = dropped;
+  waiting = false;
+  latency_count = 0;
+  latency_sum_us = 0;
+  latency_max = 0;
+}
+
+/**
+ * @arg time, plat_cycles of a move
+ * Counts the time from the oldest change the move used
+ */
+void input_moved(unsigned int time)
+{
+  if (!waiting) {
+    return;
+  }
+  unsigned int cycles = time - waiting_since;
+  waiting = false;
+  latency_count++;
+  latency_sum_us += cycles / PLAT_CYCLES_PER_US;
+  if (cycles > latency_max) {
+    latency_max = cycles;
+  }
+}
+
+/**
+ * Prints how long changes of the switches waited for a move, and how
+ * many did not fit in the queue
+ */
+void input_dump(void)
+{
+  if (latency_count == 0 && dropped == 0) {
+    return;
+  }
+  print("input: ");
+  print_dec(latency_count);
+  print(" changes");
+  if (latency_count > 0) {
+    print(", mean ");
+    print_dec(latency_sum_us / latency_count);
+    print(" us, worst ");
+    print_dec(latency_max / PLAT_CYCLES_PER_US);
+    print(" us to the move");
+  }
+  print(", ");
+  print_dec(dropped);
+  print(" dropped\n");
+}
+
+/**
+ * @arg turns, the turns of one player
+ * @arg bits, bit 0 for the right switch and bit 1 for the left one
+ * Starts without queued turns from the switches as they are
+ */
+void input_turns_reset(InputTurns *turns, int bits)
+{
+  turns->first = 0;
+  turns->count = 0;
+  turns->last = bits & 3;
+}
+
+/**
+ * @arg turns, the turns of one player
+ * @arg bits, the right and left bits of a snapshot, in order
+ * Queues a turn when a switch went up. The turn is what the switches
+ * are at that point, so raising left while right is up goes straight
+ */
+void input_turns_event(InputTurns *turns, int bits)
+{
+  bits &= 3;
+  if ((bits & ~turns->last) && turns->count < INPUT_TURNS) {
+    turns->turns[(turns->first + turns->count) % INPUT_TURNS] = bits;
+    turns->count++;
+  }
+  turns->last = bits;
+}
+
+/**
+ * @arg turns, the turns of one player
+ * @return the right and left bits for this move: the oldest queued
+ * turn, or the switches that are up if none is queued
+ */
+int input_turns_next(InputTurns *turns)
+{
+  if (turns->count == 0) {
+    return turns->last;
+  }
+  int bits = turns->turns[turns->first];
+  turns->first = (turns->first + 1) % INPUT_TURNS;
+  turns->count--;
+  return bits;
+}
@@ -0,0 +1,50 @@
+/* input.h
+
+   Switch changes from the interrupt handler to the game loop.
+
+   switch_interrupt pushes a snapshot of the switches with the time it
+   happened into a ring, and the game loop pops them in order, so no
+   change is lost or reordered however many happen between two moves.
+   There is one writer (the interrupt) and one reader (the game loop):
+   each side only writes its own index, so no locks or masking are
+   needed.
+
+   InputTurns turns the snapshots of one player into moves. A switch
+   that goes up queues a turn, so a quick tap still turns the snake
+   even when the switch is down again before the next move, and a tap
+   left and then right between two moves gives one turn each on the
+   next two moves. With no turn queued the switches that are up decide,
+   as before. */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+
+#define INPUT_QUEUE_SIZE 16 // power of two
+#define INPUT_TURNS 8       // turns a player can be ahead of the snake
+
+typedef struct {
+    int switches;      // plat_switches when the switches changed
+    unsigned int time; // plat_cycles then
+} InputEvent;
+
+typedef struct {
+    unsigned char turns[INPUT_TURNS]; // right and left bits of each queued turn
+    int first;
+    int count;
+    int last; // right and left bits of the last snapshot
+} InputTurns;
+
+bool input_push(int switches, unsigned int time);
+bool input_pop(InputEvent *event);
+bool input_pending(void);
+void input_clear(void);
+void input_moved(unsigned int time);
+void input_dump(void);
+
+void input_turns_reset(InputTurns *turns, int bits);
+void input_turns_event(InputTurns *turns, int bits);
+int input_turns_next(InputTurns *turns);
+
+#endif /* INPUT_H */
@@ -0,0 +1,91 @@
+/* io.c
+
+   The LED, 7-segment display, switch and button helpers from Lab3,
+   moved out of labmain.c and written on top of platform.h.
+
+   Written by Adam Carlström and Arvid Wilhelmsson */
+
+#include "io.h"
+#include "platform.h"
+
+/* Segment patterns for 0-9, active low with bit 7 as the decimal point */
+static const unsigned char segment_patterns[10] = {
+  0b11000000, 0b11111001, 0b10100100, 0b10110000, 0b10011001,
+  0b10010010, 0b10000010, 0b11111000, 0b10000000, 0b10011000,
+};
+#define SEGMENT_ALL_ON 0b11111111 // shown for a value that is not a digit
+#define SEGMENT_POINT  0b10000000 // cleared to light the decimal point
+
+/* Last value written to each register, -1 until the first write, so
+   writing the same value again costs no MMIO store */
+static int led_shadow = -1;
+static int segment_shadow[DISPLAY_COUNT] = {-1, -1, -1, -1, -1, -1};
+
+static void write_segments(int display_number, int pattern)
+{
+  if (segment_shadow[display_number] != pattern) {
+    segment_shadow[display_number] = pattern;
+    plat_segments(display_number, pattern);
+  }
+}
+
+/**
+ * @author Adam Carlström and Arvid Wilhelmsson
+ * @arg led_mask, is an integer to determine which leds should be turned ON/OFF
+ * This is the same function that is used in Lab3 for the Dtek course
+ */
+void set_leds(int led_mask){
+  int lsb = led_mask & 0x3FF;
+  if (lsb != led_shadow) {
+    led_shadow = lsb;
+    plat_leds(lsb);
+  }
+}
+/**
+ * @author Adam Carlström and Arvid Wilhelmsson
+ * @arg display_number, is the number for the display this value is to be shown at
+ * @arg value, is the value 0-9 to be shown on the display
+ * This is the same function that is used in Lab3 for the Dtek course
+ */
+void set_displays(int display_number, int value){//mellan 0-9
+  if (value >= 0 && value <= 9) {
+    write_segments(display_number, segment_patterns[value]);
+  } else {
+    write_segments(display_number, SEGMENT_ALL_ON); // if its broken, show all leds turned on
+  }
+}
+
+/**
+ * @arg bcd, six BCD digits with display 0 in the lowest nibble
+ * @arg point, lights the decimal point of the leftmost display
+ * Shows a number on all displays, only the digits that changed are written
+ */
+void set_displays_bcd(unsigned int bcd, bool point){
+  for (int i = 0; i < DISPLAY_COUNT; i++) {
+    int pattern = segment_patterns[(bcd >> (4 * i)) & 0xF];
+    if (point && i == DISPLAY_COUNT - 1) {
+      pattern &= ~SEGMENT_POINT;
+    }
+    write_segments(i, pattern);
+  }
+}
+
+/**
+ * @author Adam Carlström and Arvid Wilhelmsson
+ * This is the same function that is used in Lab3 for the Dtek course
+ * The function is used to get the value for all switches
+ */
+int get_sw(void){
+  //0x04000010
+  return (plat_switches() & 0x3FF);
+}
+
+/**
+ * @author Adam Carlström and Arvid Wilhelmsson
+ * This is the same function that is used in Lab3 for the Dtek course
+ * The function is used to get the value of the lower button
+ */
+int get_btn(void){
+  //0x040000d0
+  return (plat_buttons() & 0x1);
+}
@@ -0,0 +1,20 @@
+/* io.h
+
+   Lab3 helpers for the LEDs, 7-segment displays, switches and button.
+   The LED and display writes go through shadow copies of the
+   registers and are skipped when nothing changed */
+
+#ifndef IO_H
+#define IO_H
+
+#include <stdbool.h>
+
+#define DISPLAY_COUNT 6 // 7-segment displays
+
+void set_leds(int led_mask);
+void set_displays(int display_number, int value);
+void set_displays_bcd(unsigned int bcd, bool point);
+int get_sw(void);
+int get_btn(void);
+
+#endif /* IO_H */
@@ -12,9 +12,25 @@
 //#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include "platform.h"
+#include "snake.h"
+#include "render.h"
+#include "vga.h"
+#include "io.h"
+#include "sched.h"
+#include "probe.h"
+#include "score.h"
+#include "mem.h"
+#include "record.h"
+#include "autopilot.h"
+#include "hud.h"
+#include "arena.h"
+#include "input.h"
 
 extern void print(const char*);
 extern void print_dec(unsigned int);
+extern int print_drain(void);
+extern int print_pending(void);
 extern void display_string(char*);
 extern void time2string(char*,int);
 extern void tick(int*);
@@ -22,548 +38,185 @@ extern void delay(int);
 extern int nextprime( int );
 extern void enable_interrupts(void);
 
-void set_leds(int led_mask);
-void set_displays(int display_number, int value);
-int get_sw(void);
-int get_btn(void);
 void display_time(int mytime);
 
-#define BOARD_SIZE 16
-
-#define VGA_BASE 0x08000000
-#define SCREEN_WIDTH 320
-#define SCREEN_HEIGHT 240
-#define CELL_WIDTH (SCREEN_WIDTH / BOARD_SIZE)
-#define CELL_HEIGHT (SCREEN_HEIGHT / BOARD_SIZE)
-
-
-// Structs used for the snake
-
-// Position struct to hold row and column
-typedef struct {
-    int row;
-    int col;
-} Position;
-
-// Queue to hold the snake's body segments
-typedef struct {
-    Position segments[BOARD_SIZE * BOARD_SIZE];
-    int head;
-    int tail;
-    int length;
-    bool right;
-    bool left;
-    int direction;
-    bool snake_playing;
-} Snake;
-
-
 // Global variables
 // mostly necessary as they are used in handle_interrupt and other functions simultaneosly 
-int seed = 0;
-int timeoutcount = 0;
-bool changeDirection = false;
+// volatile since they change in handle_interrupt behind the game loop's back
+volatile bool buttonPressed = false;
 bool speedup = false;
 
-/** 
- * Below is the function that will be called when an interrupt is triggered. 
-* @author Adam Carlström
-* @author Arvid Wilhelmsson
-* @arg cause, holds an integer value directly connected to what caused the interrupt
-* In this case cause 16 is called because of the timer (see labinit)
-* Cause 17 is for switches
-*/
-void handle_interrupt(unsigned cause) 
-{
-  if (cause == 16){
-  volatile unsigned short *status_reg = (unsigned short*) 0x04000020;
-  *status_reg = 0; // reset to 0 so that it doesn't continously call interrupts
-  timeoutcount+=2; // increase global timer
-  if(speedup) // if speedup is enabled increase timer again so it basically goes 2x speed
-    timeoutcount+=2;
-  }
+#define DEMO_RESTART_BLINKS 3 // seconds between demo games, see SCHED_BLINK
+#define BUTTON_DEBOUNCE_US 20000 // presses closer than this are one press
 
-  if(cause == 17) {// called every time a switch is changed
-    volatile unsigned short *switch_reg_edge = (unsigned short*) 0x0400001C;
-    *switch_reg_edge = 0; // reset so it doesn't continously call interrupts
-    
-    changeDirection = true; // change global value so that game knows that switches have changed
-  }
-}
+#define AUTOPILOT_SWITCH 8 // SW8 lets the snake steer itself, see autopilot.h
+static Autopilot pilot; // static since it grows with the world
 
-/**
-* @author Arvid Wilhelmsson
-* @arg row, the row where something should be drawn
-* @arg col, the column where something should be drawn
-* @arg color, the color something should be drawn in
-* Function is used to draw rectangles on certain coordinates for the board via the VGA
-* Additionally it draws a border around each cell
- */
-void draw_cell(int row, int col, int color) {
-    volatile char *vga = (volatile char *) VGA_BASE;
-
-    // Define cell boundaries
-    int start_y = row * CELL_HEIGHT;
-    int end_y = start_y + CELL_HEIGHT;
-    int start_x = col * CELL_WIDTH;
-    int end_x = start_x + CELL_WIDTH;
-
-    // Border thickness (1 pixel)
-    int border_color = 0xFFFFFF;  // Black or any other color
-    int space = 2; // space between dots for border
-    for (int y = start_y; y < end_y; y++) {
-        for (int x = start_x; x < end_x; x++) {
-            // Draw border: top, bottom, left, right
-            if ((y == start_y || y == end_y - 1 || x == start_x || x == end_x - 1) && (y%space == 0 && x%space == 0)) {
-                vga[y * SCREEN_WIDTH + x] = (char) border_color;
-            } else {
-                // Draw the cell's main color inside the border
-                vga[y * SCREEN_WIDTH + x] = (char) color;
-            }
-        }
-    }
-}
- /**
-  * @author Arvid Wilhelmsson
-  * @arg board[], the board containing information about where the snake and food is
-  * @arg *snake, contains information about the snake (see snake struct)
-  * This function is used to go through each part of the board
-  * and check what is on there to determine what color the VGA should
-  * draw on this space
-  */
-void render_board(int board[BOARD_SIZE][BOARD_SIZE], Snake *snake) {
-    for (int row = 0; row < BOARD_SIZE; row++) {
-        for (int col = 0; col < BOARD_SIZE; col++) {
-            int color = 0; // Default color (e.g., empty cell)
-            if (board[row][col] == 1) {// meaning a snake part is here
-              //overly complex if-state to check if this part of the snake is the head
-              if(snake->segments[snake->head].row == row && snake->segments[snake->head].col == col){
-                color =0x123456; // head color (blue-ish)
-              }else{
-                color = 0x654321; // Snake body color (white)
-              }
-            } else if (board[row][col] == 2) { // meaning a fruit is here
-                color = 0x2B2DCC; // Fruit color (Orange-ish)
-            }
-            draw_cell(row, col, color);
-        }
-    }
-}
- /**
-  * @author Arvid Wilhelmsson
-  * @arg color, the color something should be drawn
-  * Used to clear the VGA screen by making every pixel the same color
-  * CURRENTLY UNUSED (caused flickering and was found to be unecessary)
-  */
-void clear_screen(int color) {
-    volatile char *vga = (volatile char *) VGA_BASE;
-    for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
-        vga[i] = (char) color;
-    }
-}
+#define ARENA_SWITCH 3 // SW3 at the start of a game, see arena.h
+#define PLAYER2_RIGHT_SWITCH 4 // player 2 turns with SW4 and SW5 like SW0 and SW1
+#define PLAYER2_LEFT_SWITCH 5
+#define SMOOTH_SWITCH 6 // SW6 slides the snake between moves, see render_animate_move
 
-/**
- * @author Adam Carlström (copied by)
- * @arg seed, used to determine randomness
- * @return a (pseudo) random integer value
- * This code was found in a discussion on the Dtek canvas page created by Albin Sijmer
- * The code was created by Natan Odin Herman Hyötyläinen and further altered by Fredrik Lundevall
- */
-unsigned int random_value(unsigned int* seed) {
-  static int hasbeencalled = 0; /* flag */
-  static unsigned int state;
-  if( !hasbeencalled ) {
-    hasbeencalled = 1;
-    state = *seed; /* the pointer seed is only used once */ 
-  }
-  /* actual pseudo-random number generation starts here */
-  state = state * 747796405 + 2891336453;
-  unsigned int result = ((state >> ((state >> 28) + 4)) ^ state) * 277803737;
-  result = (result >> 22) ^ result;
-  return result;
-}
+// Columns of the HUD line below the board, see hud.h
+#define HUD_SCORE 0     // "SCORE 000042"
+#define HUD_BEST 13     // "BEST 000100"
+#define HUD_INTERVAL 25 // "250MS", time between moves
+#define HUD_STATE 31    // "GAME OVER" or "YOU WIN!"
 
 /**
- * @author Adam Carlström and Arvid Wilhelmsson
- * This is the same function used to solve Lab3 for the dtek course
- * Here certain registers have their interrupts enabled which is used
- * in the handle_interrupt function found further up
- * The general timer is also set to call timeouts every 100ms (10 per second)
+ * @arg *snake, the snake whose game is shown
+ * @arg state, what goes in the state column, blank during the game
+ * Updates the HUD text, hud_render only draws the characters that changed
  */
-void labinit(void)
+static void update_hud(Snake *snake, const char *state)
 {
-  //0x04000020-0x0400003F
-  //0001000111100001 1010001100000000
-
-  //periodl 0x04000028
-  volatile unsigned short *control_reg = (unsigned short*) 0x04000024;
-  volatile unsigned short *periodl = (unsigned short*) 0x04000028;
-  volatile unsigned short *periodh = (unsigned short*) 0x0400002C;
-
-  *(periodl) = (29999999/10) & 0xFFFF;  
-  *(periodh) = (29999999/10) >> 16;
-  
-  *(control_reg) = 0x7;
-
-  volatile unsigned short *switch_reg_interrupt = (unsigned short*) 0x04000018;
-
-  *switch_reg_interrupt = 0b1111111111;
-
-  enable_interrupts();
-}
-
-/**
- * @author Adam Carlström and Arvid Wilhelmsson
- * @arg led_mask, is an integer to determine which leds should be turned ON/OFF
- * This is the same function that is used in Lab3 for the Dtek course
- */
-void set_leds(int led_mask){
-  int lsb = led_mask & 0x3FF;
-  volatile int *leds_address = (volatile int*) 0x04000000;
-  // 0x04000000
-  *leds_address = lsb;
-}
-/**
- * @author Adam Carlström and Arvid Wilhelmsson
- * @arg display_number, is the number for the display this value is to be shown at
- * @arg value, is the value 0-9 to be shown on the display
- * This is the same function that is used in Lab3 for the Dtek course
- */
-void set_displays(int display_number, int value){//mellan 0-9
-
-  //int lsb = display_number & 0x7F;
-  int binary_value = 0;
-  switch(value){
-    case 0:
-      binary_value = 0b11000000;
-      break;
-    case 1:
-      binary_value = 0b11111001;
-      break;
-    case 2:
-      binary_value = 0b10100100;
-      break;
-    case 3:
-      binary_value = 0b10110000;
-      break;
-    case 4:
-      binary_value = 0b10011001;
-      break;
-    case 5:
-      binary_value = 0b10010010;
-      break;
-    case 6:
-      binary_value = 0b10000010;
-      break;
-    case 7:
-      binary_value = 0b11111000;
-      break;
-    case 8:
-      binary_value = 0b10000000;
-      break;
-    case 9:
-      binary_value = 0b10011000;
-      break;
-    default:
-      binary_value = 0b11111111;//if its broken, show all leds turned on
-      break;
+  static unsigned int shown_interval; // in decimal only when it changes
+  unsigned int interval = sched_move_interval(snake->length, speedup);
+  hud_bcd(HUD_SCORE + 6, score_bcd(), DISPLAY_COUNT);
+  hud_bcd(HUD_BEST + 5, score_high_bcd(), DISPLAY_COUNT);
+  if (interval != shown_interval) {
+    hud_number(HUD_INTERVAL, interval / 1000, 3);
+    shown_interval = interval;
   }
-    
-  volatile int *display_address = (volatile int*) (0x04000050 + 0x10 *display_number);
-  *display_address = binary_value;
-}
-
-/**
- * @author Adam Carlström and Arvid Wilhelmsson
- * This is the same function that is used in Lab3 for the Dtek course
- * The function is used to get the value for all switches
- */
-int get_sw(void){
-  //0x04000010
-  volatile int *toggle_address = (volatile int*) (0x04000010);
-  return ((*toggle_address) & 0x3FF);
-}
-
-/**
- * @author Adam Carlström and Arvid Wilhelmsson
- * This is the same function that is used in Lab3 for the Dtek course
- * The function is used to get the value of the lower button
- */
-int get_btn(void){
-  //0x040000d0
-  volatile int *btn_address = (volatile int*) (0x040000d0);
-  return ((*btn_address) & 0x1);
+  hud_text(HUD_STATE, state);
 }
 
 /**
- * @author Adam Carlström
- * @arg snake, the variable holding the snake struct
- * @arg startrow, the starting row coordinate for the snake
- * @arg startcol, the starting column coordinate for the snake
- * @arg initalLength, the starting length for the snake
- * This function initializes all the values for the snake struct
+ * @arg arena, a game that is over
+ * @arg winner, see arena_winner
+ * Prints who won and the length and kills of every snake
  */
-void initSnake(Snake *snake, int startRow, int startCol, int initialLength) {
-    snake->head = initialLength - 1;
-    snake->tail = 0;
-    snake->length = initialLength;
-    snake-> snake_playing = true;
-    snake->right = false;
-    snake->left = false;
-    snake->direction = 1; // 0 = north, 1 = east, 2 = south, 3 = west
-
-    // Populate the initial snake segments, starting horizontally from left to right
-    for (int i = 0; i < initialLength; i++) {
-        snake->segments[i] = (Position){startRow, startCol + i};
-    }
+static void print_arena(const Arena *arena, int winner)
+{
+  if(winner < 0){
+    print("DRAW\n");
+  }else{
+    print("PLAYER ");
+    print_dec(winner + 1);
+    print(" WINS\n");
+  }
+  for(int id = 0; id < ARENA_SNAKES; id++){
+    print(id < ARENA_PLAYERS ? "player " : "snake ");
+    print_dec(id + 1);
+    print(": length ");
+    print_dec(arena->snakes[id].length);
+    print(", kills ");
+    print_dec(arena->kills[id]);
+    print("\n");
+  }
 }
 
-/**
- * @author Adam Carlström
- * @arg Snake, the variable holding the snake struct
- * This function is called if the snake has died
- */
-void gameOver(Snake *snake){
-    print("YOU LOST \n");
-    print("Press button to replay \n");
-    snake->snake_playing = false;
-    set_leds(2047);// 2^11-1 = all leds turned on
-}
+#ifdef IRQ_LATENCY
+// Filled in by boot.S: interrupts taken, their total and their largest
+// number of cycles from entry to mret, for the full and the vectored path
+extern unsigned int irq_latency_full[3];
+extern unsigned int irq_latency_fast[3];
 
-/**
- * @author Arvid Wilhelmsson
- * @arg Snake, the variable holding the snake struct
- * This function is called if the snake has a total length of 100
- * meaning it has filled the board and therefore won the game
- */
-void gameWin(Snake *snake){
-    print("You won \n");
-    snake->snake_playing = false;
-    set_leds(1365);// 2^10 + 2^8 + 2^6 + 2^4 + 2^2 + 2^0 = 1365 = every other led turned on
+static void print_latency(const char *path, const unsigned int *stats)
+{
+  print("interrupts, ");
+  print(path);
+  print(" path: ");
+  print_dec(stats[0]);
+  if(stats[0] > 0){
+    print(", mean ");
+    print_dec(stats[1] / stats[0]);
+    print(" cycles, worst ");
+    print_dec(stats[2]);
+    print(" cycles");
+  }
+  print("\n");
 }
+#endif
 
 /**
- * @author Adam Carlström
- * @arg Snake, the variable holding the snake struct
- * @arg newhead, a position/coordinate for the new position of the head
- * Add a new head position to the snake
+ * Timer interrupt, cause 16. boot.S calls it straight from its vector
  */
-void addHead(Snake *snake, Position newHead) {
-    snake->head = (snake->head + 1) % (BOARD_SIZE * BOARD_SIZE);
-    snake->segments[snake->head] = newHead;
-    snake->length++;
-}
-/**
- * @author Adam Carlström
- * @arg Snake, the variable holding the snake struct
- * Remove the tail position of the snake
- */
-void removeTail(Snake *snake) {
-    snake->tail = (snake->tail + 1) % (BOARD_SIZE * BOARD_SIZE);
-    snake->length--;
+void timer_interrupt(void)
+{
+  PROBE_BEGIN(PROBE_INTERRUPT);
+  plat_timer_ack(); // reset to 0 so that it doesn't continously call interrupts
+  sched_timer_interrupt(); // see sched.c for when moves and frames happen
+  PROBE_END(PROBE_INTERRUPT);
 }
 
 /**
- * @author Adam Carlström
- * @arg board, the board used for the game
- * The function makes sure new fruit spawns in a position that is empty
+ * Switch interrupt, cause 17, called every time a switch is changed.
+ * boot.S calls it straight from its vector
  */
-void fruitSpawnRandom(int board[BOARD_SIZE][BOARD_SIZE]){
-  int x = 0;
-  int y = 0;
-  do{
-    unsigned int tmp = (unsigned int)seed;
-    x = random_value(&tmp) % BOARD_SIZE;//random x value between 0 and 9
-    y = random_value(&tmp) % BOARD_SIZE;//random y value between 0 and 9
-  }while(board[x][y] != 0);
-  board[x][y] = 2;//mat
+void switch_interrupt(void)
+{
+  PROBE_BEGIN(PROBE_INTERRUPT);
+  plat_switch_irq_ack(); // reset so it doesn't continously call interrupts
+  input_push(get_sw(), plat_cycles()); // the game loop takes them in order, see input.h
+  PROBE_END(PROBE_INTERRUPT);
 }
 
 /**
- * @author Adam Carlström
- * @arg snake, the variable holding the snake struct
- * @arg board, the board for this game
- * The function updates the position of the snake based on 
- * the direction it wants to go and updates its head and tail
- * correspondingly. Additionally it checks how this new position
- * might affect the game by checking collision with itself,
- * walls, and fruits. Also checks if the snake dies or wins.
+ * The button bounces, so its interrupt is off for BUTTON_DEBOUNCE_US
+ * after a press. Run by the timer interrupt then, see sched_after
  */
-void moveSnake(Snake *snake, int board[BOARD_SIZE][BOARD_SIZE]) {
-    int direction_rows = 0;
-    int direction_columns = 0;
-    switch(snake->direction){
-        case 0://north
-            direction_rows = -1;
-            direction_columns = 0;
-        break;
-        case 1://east
-            direction_rows = 0;
-            direction_columns = 1;
-        break;
-        case 2://south
-            direction_rows = 1;
-            direction_columns = 0;
-        break;
-        case 3://west
-            direction_rows = 0;
-            direction_columns = -1;
-        break;
-        default: // in the case it gets here, reset directions to default
-            snake->direction = 1; //east som default
-            snake->right = false;//rakt fram som default
-            snake->left = false;
-            break;
-    }
-
-    Position newHead = {
-        snake->segments[snake->head].row + direction_rows,
-        snake->segments[snake->head].col + direction_columns
-    };
-
-    if (board[newHead.row][newHead.col] == 0) {// means snake is moving where nothing else is
-        // Remove the tail if the snake isn't growing
-        Position tailPos = snake->segments[snake->tail];
-        board[tailPos.row][tailPos.col] = 0; // Clear tail position on board
-        removeTail(snake);
-    }else if(board[newHead.row][newHead.col] == 1){// means that the snake has moved into itself
-        gameOver(snake);
-    }else if(board[newHead.row][newHead.col] == 2){// means that fruit is found here 
-        if(snake->length <= BOARD_SIZE*BOARD_SIZE-3){// only spawn fruit if there is space for it
-          fruitSpawnRandom(board); // spawn new fruit so that there is always 3 of them
-        }
-        if(snake->length >= BOARD_SIZE*BOARD_SIZE){ // check win condition
-          gameWin(snake);
-        }
-    }
-    // Check collision with walls
-    if(newHead.row >= BOARD_SIZE || newHead.row <= -1 || newHead.col >= BOARD_SIZE || newHead.col <= -1){//outofBounds
-        gameOver(snake);
-    }
-    // Add the new head to the snake
-    if(snake->snake_playing){
-      addHead(snake, newHead);
-      board[newHead.row][newHead.col] = 1; // Mark new head position on board
-    }
+static void button_debounced(void)
+{
+  plat_button_irq_ack(); // the bounces while it was off
+  plat_button_irq_enable(0x1);
 }
 
-/**
- * @author Adam Carlström
- * @arg right, boolean value to show if the user wants to turn right
- * @arg left, boolean value to show if the user wants to turn left
- * @arg currentDirection, holds the integer value for the current direction
- * @return an int for the direction it should go if it turns right/left from here
- */
-int calculateDirectionChange(bool right,bool left, int currentDirection){
-  int returnvalue = currentDirection;
-  if(right && !left){
-      returnvalue += 1;
-      if(returnvalue >= 4){//if on west = 3 and wants to go right, go to north = 0
-          return 0;
-      }   
-  }else if(!right && left){
-      returnvalue -= 1;
-      if(returnvalue <= -1){//if on north = 0 and wants to go left, go to west = 3
-          return 3;
-      }
+/** 
+ * Below is the function that will be called when an interrupt is triggered
+ * and it has no vector of its own in boot.S, or the core does not use
+ * the vectors.
+* @author Adam Carlström
+* @author Arvid Wilhelmsson
+* @arg cause, holds an integer value directly connected to what caused the interrupt
+* In this case cause 16 is called because of the timer (see labinit)
+* Cause 17 is for switches and cause 18 for the button
+*/
+void handle_interrupt(unsigned cause) 
+{
+  if (cause == 16){
+    timer_interrupt();
   }
-  return returnvalue;
-}
-
-/**
- * @author Adam Carlström
- * @arg snake, the variable holding the snake struct
- * @arg right, boolean value to show if the user wants to turn right
- * @arg left, boolean value to show if the user wants to turn left
- * Used to change the direction of the snake
- */
-void changeDirectionSnake(Snake *snake, bool right, bool left){
-    snake->right = right;
-    snake->left = left;
-    if(right && left){
-        //no change = go straight
-    }else{
-      
-      snake->direction = calculateDirectionChange(snake->right,snake->left, snake->direction);
-    }
-}
-
-/**
- * @author Arvid Wilhelmsson
- * @arg board, the board of the game
- * Function to print the board (for debugging)
- */
-void printBoard(int board[BOARD_SIZE][BOARD_SIZE]) {
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            print_dec(board[i][j]);
-            print(" ");
-        }
-        print("\n");
-    }
-    print("\n");
-}
 
-/**
- * @author Adam Carlström
- * @arg snake, the variable holding the snake struct
- * @arg board, the board of the game
- * The function is used to initialize variables to start the game
- */
-void startgame(Snake *snake, int board[BOARD_SIZE][BOARD_SIZE]){
-  //print("Game Started \n");
-  //board[x][y]
-  int initialLength = 3;
-  initSnake(snake, BOARD_SIZE/2, 1,initialLength);
-  // Mark initial snake positions on the board
-  for (int i = 0; i < initialLength; i++) {
-      Position pos = snake->segments[i];
-      board[pos.row][pos.col] = 1;
+  if(cause == 17) {
+    switch_interrupt();
   }
 
-  board[BOARD_SIZE/2+1][BOARD_SIZE-BOARD_SIZE/4-1] = 2;//mat
-  board[BOARD_SIZE/2][BOARD_SIZE-BOARD_SIZE/4] = 2;//mat
-  board[BOARD_SIZE/2-1][BOARD_SIZE-BOARD_SIZE/4-1] = 2;//mat
-}
-
-/**
- * @author Arvid Wilhelmsson (copied by)
- * @arg ptr
- * @arg value
- * @arg num
- * This code snippet was found on GeeksForGeeks.
- * Function is used to fill a block of memory with a specific value.
- * It replaces the contents of the first `num` bytes in the memory block 
- * pointed to by `ptr` with the constant byte value `value`.
- * 
- * @return The function returns a pointer to the memory block `ptr`.
- */
-
-void* memset(void* ptr, int value, size_t num) {
-    unsigned char* p = (unsigned char*) ptr;
-    for (size_t i = 0; i < num; i++) {
-        p[i] = (unsigned char) value;
+  if(cause == 18) {// called when the button is pressed
+    PROBE_BEGIN(PROBE_INTERRUPT);
+    plat_button_irq_ack();
+    buttonPressed = true;
+    plat_button_irq_enable(0);
+    if(!sched_after(BUTTON_DEBOUNCE_US, button_debounced)){
+      plat_button_irq_enable(0x1); // no timer free, so no debouncing
     }
-    return ptr;
+    PROBE_END(PROBE_INTERRUPT);
+  }
 }
 
 /**
- * @author Adam Carlström
- * arg snake
- * The function is used to update the score on the displays
+ * @author Adam Carlström and Arvid Wilhelmsson
+ * This is the same function used to solve Lab3 for the dtek course
+ * Here certain registers have their interrupts enabled which is used
+ * in the handle_interrupt function found further up
+ * The timer starts here and keeps the clock of sched.h, the game adds
+ * its own timers to it
  */
-void updateScore(Snake *snake){
-  for (int i = 1; i < 7; i++)
-  {
-    int div = 10;
-    for (int j = 1; j < i; j++)
-    {
-      div *=10;
-    }
-    int rest = snake->length%div;
-    int tot = rest / (div/10);
-    set_displays(i-1,tot);
-  }
+void labinit(void)
+{
+  plat_switch_irq_enable(0b1111111111);
+
+  plat_button_irq_enable(0x1);
+  plat_irq_unmask(18);
+
+  vga_init();
+  hud_init();
+  hud_text(HUD_SCORE, "SCORE");
+  hud_text(HUD_BEST, "BEST");
+  hud_text(HUD_INTERVAL + 3, "MS");
+  autopilot_init(&pilot);
+  sched_init();
+  enable_interrupts();
 }
 
 /**
@@ -573,85 +226,303 @@ void updateScore(Snake *snake){
  */
 void runGame(){
   set_leds(0);
-  int board[BOARD_SIZE][BOARD_SIZE] = {0}; //globalize board
-  Snake snake;
+  static Board board; // cleared by startgame
+  static Snake single; // static since it grows with the world, see BOARD_SIZE
+  static Arena arena;
+
+  // A replayed game takes its switches from the log and moves as fast
+  // as it can instead of waiting for the timer, see record.h
+  bool replaying = replay_active();
+  unsigned int moves = 0;
+  unsigned int start_cycles = plat_cycles();
 
   // the snipped of code below is used to check the initial values
   // of the switches and if the snake should turn/speed up from start
-  int switch_values = get_sw();
+  input_clear(); // changes from before the game are in get_sw already
+  int switch_values = replaying ? replay_initial_switches() : get_sw();
+  record_begin(random_get_state(), switch_values);
   int switchbits[3];
   int i = 0;
   while(i<3){
     switchbits[i] = (switch_values >> i) & 0b1;
     i++;
   }
-  startgame(&snake,board); // initialise values for the game
+  int probe_switch = (switch_values >> 9) & 1; // SW9 dumps the probes, see probe.h
+  // not while replaying, the log already has the moves it made
+  bool autopilot = !replaying && ((switch_values >> AUTOPILOT_SWITCH) & 1);
+  // SW3 starts a game for two players and the snakes of the game, see arena.h.
+  // Those are not recorded, the log only has the switches of one player
+  bool arena_mode = !replaying && ((switch_values >> ARENA_SWITCH) & 1);
+  Snake *snake = arena_mode ? arena.snakes : &single; // the one with the score
+  // a replay moves as fast as it can, so there is nothing in between to draw
+  bool smooth = !replaying && !arena_mode && ((switch_values >> SMOOTH_SWITCH) & 1);
+  autopilot_reset(&pilot);
+  probe_reset();
+  if(arena_mode){
+    arena_start(&arena, &board);
+    autopilot = false; // it only knows how to play alone
+  }else{
+    startgame(snake,&board); // initialise values for the game
+  }
+  invalidate_board(); // full redraw once, then only changed cells
+  bool frame_pending = true; // the board changed since it was last drawn
+  bool frame_due = true; // the frame tick has come
   if(switchbits[0]){
-    snake.right = true;
+    snake->right = true;
   }
   if(switchbits[1]){
-    snake.left = true;
+    snake->left = true;
   }
   if(switchbits[2]){
     speedup = true;
   } else {
     speedup = false;
   }
+  if(arena_mode){
+    arena.snakes[1].right = (switch_values >> PLAYER2_RIGHT_SWITCH) & 1;
+    arena.snakes[1].left = (switch_values >> PLAYER2_LEFT_SWITCH) & 1;
+  }
+  InputTurns turns[ARENA_PLAYERS]; // of player 1 and in the arena player 2
+  input_turns_reset(&turns[0], switch_values);
+  input_turns_reset(&turns[1], switch_values >> PLAYER2_RIGHT_SWITCH);
+  sched_every(SCHED_MOVE, sched_move_interval(snake->length, speedup));
+  sched_every(SCHED_FRAME, SCHED_FRAME_US);
+  update_hud(snake, "         ");
   //print("before loop, ");
   // while loop that goes on as long as the snake is alive and playing
-  while(snake.snake_playing){
+  while(arena_mode ? arena_playing(&arena) : snake->snake_playing){
+    // Sleep until an interrupt unless something is already due. Interrupts
+    // are masked while checking so one cannot slip in between the check and
+    // the wfi. A pending VGA swap has no interrupt so it is polled instead,
+    // and so is the JTAG UART while there is queued output (see printc)
+    print_drain();
+    unsigned int irq = plat_irq_save();
+    if(!replaying && !input_pending() && !sched_pending() && !(frame_pending && frame_due) && !print_pending()){
+      plat_wait_for_interrupt();
+    }
+    plat_irq_restore(irq);
+    unsigned int events = sched_take();
+    bool switches_changed = false;
+    if(replaying){
+      events = SCHED_MOVE | SCHED_FRAME; // every turn of the loop is a move
+      int replayed = replay_switches(moves);
+      switches_changed = replayed != switch_values;
+      switch_values = replayed;
+    } else {
+      // every change since the last turn of the loop, in the order they
+      // happened, so a tap between two moves is not lost
+      InputEvent change;
+      while(input_pop(&change)){
+        switch_values = change.switches;
+        input_turns_event(&turns[0], switch_values);
+        input_turns_event(&turns[1], switch_values >> PLAYER2_RIGHT_SWITCH);
+        if(((switch_values >> 9) & 1) && !probe_switch){
+          probe_dump();
+        }
+        probe_switch = (switch_values >> 9) & 1;
+        switches_changed = true;
+      }
+    }
+
     // This if statement checks if the user wants to change direction
-    // which comes from the global variable that is changed upon a switch interrupt
-    if(changeDirection){
-      changeDirection = false;
-      switch_values = get_sw();
+    // which comes from the switch changes handed over by switch_interrupt
+    if(switches_changed){
       i = 0;
       while(i<3){
         switchbits[i] = (switch_values >> i) & 0b1;
         i++;
       }
       if(switchbits[1] == 1){
-        snake.left = true;
+        snake->left = true;
       }else{
-        snake.left = false;
+        snake->left = false;
       }
       if(switchbits[0] == 1){
-        snake.right = true;
+        snake->right = true;
       }else{
-        snake.right = false;
+        snake->right = false;
       }
       if(switchbits[2]){
         speedup = true;
       } else {
         speedup = false;
       }
-      //showDirection(&snake, calculateDirectionChange(snake.right,snake.left,snake.direction));
+      autopilot = !replaying && !arena_mode && ((switch_values >> AUTOPILOT_SWITCH) & 1);
+      smooth = !replaying && !arena_mode && ((switch_values >> SMOOTH_SWITCH) & 1);
+      if(!smooth){
+        render_animate_stop();
+      }
+      //showDirection(snake, calculateDirectionChange(snake->right,snake->left,snake->direction));
     }
 
     // Update game logic
-    print("");//print to delay - avoid race condition
-    if (timeoutcount >= 10){
-      changeDirectionSnake(&snake, snake.right,snake.left);
-      //showDirection(&snake, snake.direction);
-      moveSnake(&snake, board);
-      timeoutcount=0;
-      updateScore(&snake);
-      render_board(board, &snake);
+    if (events & SCHED_MOVE){
+      // what the move does is recorded, not the switches, so a replay
+      // needs neither the autopilot nor the queued turns
+      if(autopilot){
+        // steers by setting snake->right and snake->left like the switches
+        record_switches(moves, autopilot_steer(&pilot, snake, &board));
+        input_turns_reset(&turns[0], switch_values); // taps while it steered are not turns
+      }else if(!replaying){
+        int bits = input_turns_next(&turns[0]);
+        snake->right = bits & 1;
+        snake->left = (bits >> 1) & 1;
+        if(arena_mode){
+          bits = input_turns_next(&turns[1]);
+          arena.snakes[1].right = bits & 1;
+          arena.snakes[1].left = (bits >> 1) & 1;
+        }else{
+          record_switches(moves, bits);
+        }
+      }
+      input_moved(plat_cycles());
+      PROBE_BEGIN(PROBE_MOVE);
+      if(arena_mode){
+        for(int player = 0; player < ARENA_PLAYERS; player++){
+          changeDirectionSnake(&arena.snakes[player], arena.snakes[player].right, arena.snakes[player].left);
+        }
+        arena_move(&arena, &board);
+      }else{
+        changeDirectionSnake(snake, snake->right,snake->left);
+        //showDirection(snake, snake->direction);
+        Position old_tail = snake->tail;
+        moveSnake(snake, &board);
+        if(smooth && snake->snake_playing){
+          render_animate_move(snake, old_tail);
+        }else{
+          render_animate_stop();
+        }
+      }
+      PROBE_END(PROBE_MOVE);
+      moves++;
+      // the speed follows the length of the snake, see sched_move_interval
+      sched_set_move_interval(sched_move_interval(snake->length, speedup));
+      PROBE_BEGIN(PROBE_SCORE);
+      score_show(false); // the score follows the length, see addHead
+      PROBE_END(PROBE_SCORE);
+      update_hud(snake, "");
+      frame_pending = true;
+    }
+    if (events & SCHED_FRAME){
+      frame_due = true;
+      if(smooth){
+        // every frame moves the head and tail a bit further
+        render_animate_progress(sched_move_progress());
+        frame_pending = true;
+      }
+    }
 
+    // Draw the new frame on the frame tick once the previous swap is done,
+    // until then the loop is free to keep handling input
+    if (frame_pending && frame_due && !vga_swap_pending()){
+      PROBE_BEGIN(PROBE_RENDER);
+      render_dirty(&board, snake);
+      PROBE_END(PROBE_RENDER);
+      vga_present();
+      frame_pending = false;
+      frame_due = false;
     }
   }
+  sched_stop(SCHED_MOVE | SCHED_FRAME);
+  // show the final move as well, with how the game ended
+  render_animate_stop();
+  score_show(false);
+  score_finish();
+  if(arena_mode){
+    int winner = arena_winner(&arena);
+    update_hud(snake, winner < 0 ? "DRAW     " : winner == 0 ? "P1 WINS  " : "P2 WINS  ");
+    print_arena(&arena, winner);
+    set_leds(2047);
+  }else{
+    update_hud(snake, snake->length >= BOARD_SIZE * BOARD_SIZE ? "YOU WIN! " : "GAME OVER");
+  }
+  while(vga_swap_pending());
+  render_dirty(&board, snake);
+  vga_present();
+
+  if(replaying){
+    int result = replay_finish(moves, snake->length);
+    print(result == REPLAY_MATCHES ? "replay matches, "
+          : result == REPLAY_TRUNCATED ? "log truncated, not compared, " : "REPLAY DIFFERS, ");
+    print_dec(moves);
+    print(" moves in ");
+    print_dec(plat_cycles() - start_cycles);
+    print(" cycles\n");
+  } else {
+    if(pilot.decisions > 0){
+      print("autopilot: ");
+      print_dec(pilot.decisions);
+      print(" decisions, worst ");
+      print_dec(pilot.worst_cycles);
+      print(" cycles\n");
+    }
+  }
+  if(!replaying && !arena_mode){
+    const unsigned char *log;
+    record_end(moves, snake->length, &log);
+#ifdef RECORD
+    record_dump(); // read by host/replay.c
+#endif
+  }
+  if(!replaying){
+    input_dump();
+  }
+  probe_dump(); // only built with -DPROBES
+#ifdef IRQ_LATENCY
+  print_latency("full", irq_latency_full);
+  print_latency("vectored", irq_latency_fast);
+#endif
 }
 
 // main function called when running file
 int main() {
   unsigned int tmp = (unsigned int) 1234567890;
   seed = random_value(&tmp);
+#ifdef REPLAY
+  // replay-log.h holds the bytes of a log as printed by snake-replay -c
+  static const unsigned char replay_log[] = {
+#include "replay-log.h"
+  };
+  if(!replay_load(replay_log, sizeof(replay_log))){
+    print("replay-log.h is not a log for this build\n");
+  }
+#endif
+#ifdef VGA_BENCH
+  vga_bench();
+#endif
+#ifdef MEM_BENCH
+  mem_bench();
+#endif
   labinit();
   runGame();
 
+  int blinks = 0;
+  sched_every(SCHED_BLINK, SCHED_BLINK_US);
   while(1){//go here after game is done
-    if(get_btn()){// press button to play again
+    // sleep until the button interrupt, see handle_interrupt
+    print_drain();
+    unsigned int irq = plat_irq_save();
+    if(!buttonPressed && !print_pending()){
+      plat_wait_for_interrupt();
+    }
+    plat_irq_restore(irq);
+    // the displays switch between the score and the high score every
+    // second, the high score with the leftmost decimal point lit
+    if(sched_take() & SCHED_BLINK){
+      blinks++;
+      score_show(blinks & 1);
+      // in the demo the next game starts by itself
+      if(blinks >= DEMO_RESTART_BLINKS && ((get_sw() >> AUTOPILOT_SWITCH) & 1)){
+        buttonPressed = true; // as if the button was pressed
+      }
+    }
+    if(buttonPressed){// press button to play again
+      buttonPressed = false;
+      sched_stop(SCHED_BLINK);
       runGame();
+      blinks = 0;
+      sched_every(SCHED_BLINK, SCHED_BLINK_US);
+      buttonPressed = false; // ignore presses during the game
     }
   }
   return 0;
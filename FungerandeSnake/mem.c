@@ -0,0 +1,267 @@
+/* mem.c
+
+   memset, memcpy, memmove and memcmp for the -nostdlib build.
+   They work a word at a time once the pointers are aligned, with the
+   inner loops unrolled to 8 words (32 bytes) so the loop overhead is
+   small next to the loads and stores. rv32imzicsr traps or is slow on
+   misaligned word accesses, so a source that is not aligned like the
+   destination is read as aligned words and shifted into place.
+
+   The host build gets these from its C library, only mem_fill32 and
+   the benchmark are built there. */
+
+#include <stdint.h>
+#include "mem.h"
+
+/* A word that may alias anything, the routines see every type */
+typedef uint32_t __attribute__((may_alias)) mem_word;
+
+/* gcc would otherwise recognise the loops below as memset and memcpy
+   and turn them into calls to themselves */
+#define MEM_NO_LIBCALL __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+#define MISALIGNED(p) ((uintptr_t) (p) & 3)
+
+/**
+ * @arg dst, the first word, must be word aligned
+ * @arg word, the value stored in every word
+ * @arg words, how many words
+ * Fills whole words, for framebuffers and other large aligned buffers
+ */
+MEM_NO_LIBCALL
+void mem_fill32(void *dst, unsigned int word, size_t words)
+{
+  mem_word *w = dst;
+  while (words >= 8) {
+    w[0] = word;
+    w[1] = word;
+    w[2] = word;
+    w[3] = word;
+    w[4] = word;
+    w[5] = word;
+    w[6] = word;
+    w[7] = word;
+    w += 8;
+    words -= 8;
+  }
+  while (words > 0) {
+    *w++ = word;
+    words--;
+  }
+}
+
+#ifndef PLATFORM_HOST
+
+MEM_NO_LIBCALL
+void *memset(void *dst, int c, size_t n)
+{
+  unsigned char *d = dst;
+  while (n > 0 && MISALIGNED(d)) {
+    *d++ = (unsigned char) c;
+    n--;
+  }
+  if (n >= 4) {
+    mem_fill32(d, ((unsigned int) c & 0xFF) * 0x01010101u, n >> 2);
+    d += n & ~(size_t) 3;
+    n &= 3;
+  }
+  while (n > 0) {
+    *d++ = (unsigned char) c;
+    n--;
+  }
+  return dst;
+}
+
+/* Copies words forwards, every load happens before the store to the
+   same or a lower address so memmove can use it when dst < src */
+MEM_NO_LIBCALL
+static void copy_forward(unsigned char *d, const unsigned char *s, size_t n)
+{
+  while (n > 0 && MISALIGNED(d)) {
+    *d++ = *s++;
+    n--;
+  }
+  mem_word *dw = (mem_word *) d;
+  if (!MISALIGNED(s)) {
+    const mem_word *sw = (const mem_word *) s;
+    while (n >= 32) {
+      uint32_t w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+      uint32_t w4 = sw[4], w5 = sw[5], w6 = sw[6], w7 = sw[7];
+      dw[0] = w0; dw[1] = w1; dw[2] = w2; dw[3] = w3;
+      dw[4] = w4; dw[5] = w5; dw[6] = w6; dw[7] = w7;
+      sw += 8;
+      dw += 8;
+      n -= 32;
+    }
+    while (n >= 4) {
+      *dw++ = *sw++;
+      n -= 4;
+    }
+    s = (const unsigned char *) sw;
+  } else if (n >= 8) {
+    // little endian: the low bytes of each word come from the end of
+    // the previous source word and the high bytes from the next one
+    unsigned int shift = MISALIGNED(s) * 8;
+    const mem_word *sw = (const mem_word *) (s - MISALIGNED(s));
+    uint32_t prev = *sw++;
+    while (n >= 8) { // keeps the next aligned load inside the source
+      uint32_t next = *sw++;
+      *dw++ = (prev >> shift) | (next << (32 - shift));
+      prev = next;
+      n -= 4;
+    }
+    s = (const unsigned char *) sw - 4 + shift / 8;
+  }
+  d = (unsigned char *) dw;
+  while (n > 0) {
+    *d++ = *s++;
+    n--;
+  }
+}
+
+MEM_NO_LIBCALL
+void *memcpy(void *restrict dst, const void *restrict src, size_t n)
+{
+  copy_forward(dst, src, n);
+  return dst;
+}
+
+MEM_NO_LIBCALL
+void *memmove(void *dst, const void *src, size_t n)
+{
+  unsigned char *d = dst;
+  const unsigned char *s = src;
+  if (d <= s || d >= s + n) {
+    copy_forward(d, s, n);
+    return dst;
+  }
+  // dst overlaps the end of src, copy backwards
+  d += n;
+  s += n;
+  if (MISALIGNED(d) == MISALIGNED(s)) {
+    while (n > 0 && MISALIGNED(d)) {
+      *--d = *--s;
+      n--;
+    }
+    mem_word *dw = (mem_word *) d;
+    const mem_word *sw = (const mem_word *) s;
+    while (n >= 16) {
+      uint32_t w3 = sw[-1], w2 = sw[-2], w1 = sw[-3], w0 = sw[-4];
+      dw[-1] = w3; dw[-2] = w2; dw[-3] = w1; dw[-4] = w0;
+      sw -= 4;
+      dw -= 4;
+      n -= 16;
+    }
+    while (n >= 4) {
+      *--dw = *--sw;
+      n -= 4;
+    }
+    d = (unsigned char *) dw;
+    s = (const unsigned char *) sw;
+  }
+  while (n > 0) {
+    *--d = *--s;
+    n--;
+  }
+  return dst;
+}
+
+MEM_NO_LIBCALL
+int memcmp(const void *a, const void *b, size_t n)
+{
+  const unsigned char *p = a;
+  const unsigned char *q = b;
+  if (MISALIGNED(p) == MISALIGNED(q)) {
+    while (n > 0 && MISALIGNED(p)) {
+      if (*p != *q)
+        return *p - *q;
+      p++;
+      q++;
+      n--;
+    }
+    // skip equal words, the differing byte is found below
+    while (n >= 4 && *(const mem_word *) p == *(const mem_word *) q) {
+      p += 4;
+      q += 4;
+      n -= 4;
+    }
+  }
+  while (n > 0) {
+    if (*p != *q)
+      return *p - *q;
+    p++;
+    q++;
+    n--;
+  }
+  return 0;
+}
+
+#endif /* PLATFORM_HOST */
+
+#ifdef MEM_BENCH
+#include "platform.h"
+#include "dtekv-lib.h"
+
+#define BENCH_BYTES 4096
+
+static unsigned int bench_src[BENCH_BYTES / 4 + 1];
+static unsigned int bench_dst[BENCH_BYTES / 4 + 1];
+
+/* The byte loop memset used to be, kept for comparison */
+MEM_NO_LIBCALL
+static void *memset_bytes(void *ptr, int value, size_t num)
+{
+  unsigned char *p = (unsigned char *) ptr;
+  for (size_t i = 0; i < num; i++) {
+    p[i] = (unsigned char) value;
+  }
+  return ptr;
+}
+
+static void report(char *name, unsigned int cycles)
+{
+  print(name);
+  print(": ");
+  print_dec(cycles / (BENCH_BYTES / 1024));
+  print(" cycles/KB\n");
+}
+
+/**
+ * Times the routines on 4 KB buffers and prints the cycles per KB
+ * over JTAG. Built with -DMEM_BENCH
+ */
+void mem_bench(void)
+{
+  unsigned char *src = (unsigned char *) bench_src;
+  unsigned char *dst = (unsigned char *) bench_dst;
+  unsigned int t0;
+
+  t0 = plat_cycles();
+  memset_bytes(dst, 0x5A, BENCH_BYTES);
+  report("memset, bytes", plat_cycles() - t0);
+
+  t0 = plat_cycles();
+  memset(dst, 0x5A, BENCH_BYTES);
+  report("memset", plat_cycles() - t0);
+
+  t0 = plat_cycles();
+  mem_fill32(dst, 0x5A5A5A5A, BENCH_BYTES / 4);
+  report("mem_fill32", plat_cycles() - t0);
+
+  t0 = plat_cycles();
+  memcpy(dst, src, BENCH_BYTES);
+  report("memcpy, aligned", plat_cycles() - t0);
+
+  t0 = plat_cycles();
+  memcpy(dst, src + 1, BENCH_BYTES);
+  report("memcpy, misaligned", plat_cycles() - t0);
+
+  t0 = plat_cycles();
+  memmove(dst + 4, dst, BENCH_BYTES - 4);
+  report("memmove, backwards", plat_cycles() - t0);
+
+  t0 = plat_cycles();
+  memcmp(dst, dst + 0, BENCH_BYTES);
+  report("memcmp, equal", plat_cycles() - t0);
+}
+#endif /* MEM_BENCH */
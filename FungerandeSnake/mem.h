@@ -0,0 +1,20 @@
+/* mem.h
+
+   Freestanding memory routines. The board build links no C library
+   (-nostdlib), but gcc still emits calls to memset and memcpy for
+   zeroed arrays and struct copies, so they have to come from here. */
+
+#ifndef MEM_H
+#define MEM_H
+
+#include <stddef.h>
+
+void *memset(void *dst, int c, size_t n);
+void *memcpy(void *restrict dst, const void *restrict src, size_t n);
+void *memmove(void *dst, const void *src, size_t n);
+int memcmp(const void *a, const void *b, size_t n);
+
+void mem_fill32(void *dst, unsigned int word, size_t words);
+void mem_bench(void);
+
+#endif /* MEM_H */
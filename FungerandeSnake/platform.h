@@ -0,0 +1,181 @@
+/* platform.h
+
+   Thin hardware layer between the game and the DTEK-V board.
+   Everything that touches a memory mapped register goes through here.
+
+   The default backend is the board itself, every function is a single
+   load or store to the register and compiles to the same code as
+   writing the address inline. Building with -DPLATFORM_HOST selects the
+   host backend in host/platform-host.c instead: a framebuffer in memory,
+   a virtual timer and scripted switches, so the game can run and be
+   profiled natively on Linux. */
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdint.h>
+
+#define TIMER_CLOCK_HZ 30000000 // the timer counts at the CPU clock
+
+#ifndef PLATFORM_HOST
+
+#define VGA_BASE 0x08000000
+
+#define IO_LEDS          ((volatile int*) 0x04000000)
+#define IO_SWITCHES      ((volatile int*) 0x04000010)
+#define IO_SWITCH_IRQ    ((volatile unsigned short*) 0x04000018)
+#define IO_SWITCH_EDGE   ((volatile unsigned short*) 0x0400001C)
+#define IO_TIMER_STATUS  ((volatile unsigned short*) 0x04000020)
+#define IO_TIMER_CONTROL ((volatile unsigned short*) 0x04000024)
+#define IO_TIMER_PERIODL ((volatile unsigned short*) 0x04000028)
+#define IO_TIMER_PERIODH ((volatile unsigned short*) 0x0400002C)
+#define IO_TIMER_SNAPL   ((volatile unsigned short*) 0x04000030)
+#define IO_TIMER_SNAPH   ((volatile unsigned short*) 0x04000034)
+#define IO_JTAG_UART     ((volatile unsigned int*) 0x04000040)
+#define IO_JTAG_CTRL     ((volatile unsigned int*) 0x04000044)
+#define IO_DISPLAYS      0x04000050 // one register every 0x10 bytes
+#define IO_BUTTONS       ((volatile int*) 0x040000d0)
+#define IO_BUTTON_IRQ    ((volatile int*) 0x040000d8)
+#define IO_BUTTON_EDGE   ((volatile int*) 0x040000dc)
+#define IO_VGA_BUFFER     ((volatile unsigned int*) 0x04000100)
+#define IO_VGA_BACKBUFFER ((volatile unsigned int*) 0x04000104)
+#define IO_VGA_STATUS     ((volatile unsigned int*) 0x0400010C)
+
+static inline void plat_leds(int mask) { *IO_LEDS = mask; }
+static inline int plat_switches(void) { return *IO_SWITCHES; }
+static inline void plat_switch_irq_enable(int mask) { *IO_SWITCH_IRQ = mask; }
+static inline void plat_switch_irq_ack(void) { *IO_SWITCH_EDGE = 0; }
+static inline int plat_buttons(void) { return *IO_BUTTONS; }
+static inline void plat_button_irq_enable(int mask) { *IO_BUTTON_IRQ = mask; }
+static inline void plat_button_irq_ack(void) { *IO_BUTTON_EDGE = 0; }
+
+static inline void plat_segments(int display, int pattern)
+{
+  *(volatile int*) (IO_DISPLAYS + 0x10 * display) = pattern;
+}
+
+/* Starts the timer with interrupts, restarting every period_cycles */
+static inline void plat_timer_start(unsigned int period_cycles)
+{
+  *IO_TIMER_PERIODL = period_cycles & 0xFFFF;
+  *IO_TIMER_PERIODH = period_cycles >> 16;
+  *IO_TIMER_CONTROL = 0x7; // ITO | CONT | START
+}
+static inline void plat_timer_ack(void) { *IO_TIMER_STATUS = 0; }
+static inline int plat_timer_timed_out(void) { return *IO_TIMER_STATUS & 0x1; } // TO, until acked
+
+/* Current value of the counter, which counts down to 0 */
+static inline unsigned int plat_timer_remaining(void)
+{
+  *IO_TIMER_SNAPL = 0; // any write latches the counter
+  return *IO_TIMER_SNAPL | ((unsigned int) *IO_TIMER_SNAPH << 16);
+}
+
+/* Free running counters, the low 32 bits are enough for intervals */
+#define PLAT_CYCLES_PER_US (TIMER_CLOCK_HZ / 1000000) // of plat_cycles
+static inline unsigned int plat_cycles(void)
+{
+  unsigned int c;
+  asm volatile ("csrr %0, mcycle" : "=r"(c));
+  return c;
+}
+static inline unsigned int plat_instret(void)
+{
+  unsigned int n;
+  asm volatile ("csrr %0, minstret" : "=r"(n));
+  return n;
+}
+static inline unsigned int plat_hpm3(void)
+{
+  unsigned int n;
+  asm volatile ("csrr %0, mhpmcounter3" : "=r"(n));
+  return n;
+}
+
+static inline int plat_jtag_space(void) { return (*IO_JTAG_CTRL) & 0xffff0000; }
+static inline void plat_jtag_write(char c) { *IO_JTAG_UART = c; }
+
+static inline uintptr_t plat_vga_frontbuffer(void) { return *IO_VGA_BUFFER; }
+static inline uintptr_t plat_vga_backbuffer(void) { return *IO_VGA_BACKBUFFER; }
+static inline void plat_vga_set_backbuffer(uintptr_t addr) { *IO_VGA_BACKBUFFER = addr; }
+static inline void plat_vga_swap(void) { *IO_VGA_BUFFER = 0; } // any write requests a swap
+static inline int plat_vga_swap_pending(void) { return *IO_VGA_STATUS & 0x1; }
+
+/* MIE and the two bits enable_interrupts sets in mstatus */
+#define MSTATUS_IRQ_BITS 0xB
+
+/* Masks interrupts, returns what plat_irq_restore needs to unmask them */
+static inline unsigned int plat_irq_save(void)
+{
+  unsigned int old;
+  asm volatile ("csrrci %0, mstatus, %1" : "=r"(old) : "i"(MSTATUS_IRQ_BITS) : "memory");
+  return old & MSTATUS_IRQ_BITS;
+}
+static inline void plat_irq_restore(unsigned int old)
+{
+  asm volatile ("csrs mstatus, %0" : : "r"(old) : "memory");
+}
+
+/* Enables one interrupt cause in mie */
+static inline void plat_irq_unmask(int cause)
+{
+  asm volatile ("csrs mie, %0" : : "r"(1u << cause));
+}
+
+/* Sleeps until an interrupt is pending, also when they are masked,
+   so plat_irq_save + check + wfi + plat_irq_restore cannot miss one */
+static inline void plat_wait_for_interrupt(void)
+{
+  asm volatile ("wfi" : : : "memory");
+}
+
+#else /* PLATFORM_HOST */
+
+extern unsigned char host_vga[];
+#define VGA_BASE ((uintptr_t) host_vga)
+
+void plat_leds(int mask);
+int plat_switches(void);
+void plat_switch_irq_enable(int mask);
+void plat_switch_irq_ack(void);
+int plat_buttons(void);
+void plat_button_irq_enable(int mask);
+void plat_button_irq_ack(void);
+void plat_segments(int display, int pattern);
+void plat_timer_start(unsigned int period_cycles);
+void plat_timer_ack(void);
+int plat_timer_timed_out(void); // always 0, the handler runs at the timeout
+unsigned int plat_timer_remaining(void);
+#define PLAT_CYCLES_PER_US 1000 // plat_cycles counts nanoseconds
+unsigned int plat_cycles(void); // nanoseconds of host time
+unsigned int plat_instret(void); // always 0
+unsigned int plat_hpm3(void); // always 0
+int plat_jtag_space(void);
+void plat_jtag_write(char c);
+uintptr_t plat_vga_frontbuffer(void);
+uintptr_t plat_vga_backbuffer(void);
+void plat_vga_set_backbuffer(uintptr_t addr);
+void plat_vga_swap(void);
+int plat_vga_swap_pending(void);
+unsigned int plat_irq_save(void);
+void plat_irq_restore(unsigned int old);
+void plat_irq_unmask(int cause);
+void plat_wait_for_interrupt(void);
+
+/* Host side controls, see host/platform-host.c */
+typedef struct {
+  unsigned long long cycle; // virtual cycle the switches change at
+  int switches;
+} HostSwitchEvent;
+
+void host_set_irq_handler(void (*handler)(unsigned cause));
+void host_script_switches(const HostSwitchEvent *events, int count);
+void host_set_buttons(int buttons);
+void host_advance(unsigned long long cycles);
+unsigned long long host_cycles(void);
+uintptr_t host_vga_front(void);
+void host_set_quiet(int quiet);
+
+#endif /* PLATFORM_HOST */
+
+#endif /* PLATFORM_H */
@@ -0,0 +1,136 @@
+/* probe.c
+
+   Statistics table behind the probes in probe.h.
+   Everything is fixed size and updated in place, so a probe costs a
+   few counter reads and adds and never allocates. */
+
+#include "probe.h"
+
+#ifdef PROBES
+
+#include "dtekv-lib.h"
+
+#define PROBE_BUCKETS 16 // bucket b counts samples of 2^b .. 2^(b+1)-1 cycles
+
+typedef struct {
+  unsigned int count;
+  unsigned int min;
+  unsigned int max;
+  unsigned long long sum;
+  unsigned long long instret_sum;
+#ifdef PROBE_HPM
+  unsigned long long hpm_sum;
+#endif
+  unsigned int histogram[PROBE_BUCKETS];
+} ProbeStats;
+
+static const char *probe_names[PROBE_COUNT] = {
+  "moveSnake",
+  "render_dirty",
+  "score_show",
+  "interrupts",
+};
+
+static ProbeStats probes[PROBE_COUNT];
+
+/* floor(log2(x)) clamped to the histogram, without __builtin_clz
+   which would need libgcc */
+static int bucket(unsigned int x)
+{
+  int b = 0;
+  while (x > 1 && b < PROBE_BUCKETS - 1) {
+    x >>= 1;
+    b++;
+  }
+  return b;
+}
+
+/**
+ * @arg id, which probe
+ * @arg start, the counters read by PROBE_BEGIN
+ * Adds the time since start to the statistics of the probe
+ */
+void probe_record(int id, ProbeStart start)
+{
+  ProbeStart end = probe_now();
+  unsigned int cycles = end.cycles - start.cycles;
+  ProbeStats *p = &probes[id];
+
+  if (p->count == 0 || cycles < p->min)
+    p->min = cycles;
+  if (cycles > p->max)
+    p->max = cycles;
+  p->count++;
+  p->sum += cycles;
+  p->instret_sum += end.instret - start.instret;
+#ifdef PROBE_HPM
+  p->hpm_sum += end.hpm - start.hpm;
+#endif
+  p->histogram[bucket(cycles)]++;
+}
+
+/**
+ * Clears the statistics of every probe
+ */
+void probe_reset(void)
+{
+  for (int id = 0; id < PROBE_COUNT; id++) {
+    unsigned int *words = (unsigned int *) &probes[id];
+    for (unsigned int i = 0; i < sizeof(ProbeStats) / sizeof(unsigned int); i++)
+      words[i] = 0;
+  }
+}
+
+/* 64 by 32 bit division by shift and subtract, since the 64-bit
+   division in libgcc is not linked */
+static unsigned int div64(unsigned long long n, unsigned int d)
+{
+  unsigned long long q = 0;
+  unsigned long long r = 0;
+  for (int i = 63; i >= 0; i--) {
+    r = (r << 1) | ((n >> i) & 1);
+    if (r >= d) {
+      r -= d;
+      q |= 1ull << i;
+    }
+  }
+  return (unsigned int) q;
+}
+
+static void print_field(char *name, unsigned int value)
+{
+  print(name);
+  print_dec(value);
+}
+
+/**
+ * Prints the statistics of every probe over the JTAG UART
+ */
+void probe_dump(void)
+{
+  print("\n--- probes (cycles) ---\n");
+  for (int id = 0; id < PROBE_COUNT; id++) {
+    ProbeStats *p = &probes[id];
+    print((char *) probe_names[id]);
+    if (p->count == 0) {
+      print(": no samples\n");
+      continue;
+    }
+    print_field(": n=", p->count);
+    print_field(" min=", p->min);
+    print_field(" max=", p->max);
+    print_field(" mean=", div64(p->sum, p->count));
+    print_field(" instret=", div64(p->instret_sum, p->count));
+#ifdef PROBE_HPM
+    print_field(" hpm3=", div64(p->hpm_sum, p->count));
+#endif
+    print("\n  log2 histogram:");
+    for (int b = 0; b < PROBE_BUCKETS; b++) {
+      print(" ");
+      print_dec(p->histogram[b]);
+    }
+    print("\n");
+  }
+}
+
+#endif /* PROBES */
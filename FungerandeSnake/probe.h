@@ -0,0 +1,63 @@
+/* probe.h
+
+   Cycle counting probes for the hot paths. A probe is a pair of
+   PROBE_BEGIN(id) / PROBE_END(id) in the same scope. Each one keeps
+   the count, min, max, mean and a log2 histogram of the cycles (and
+   instructions) spent between the two, and probe_dump prints the
+   table over the JTAG UART.
+
+   Build with make DEFS=-DPROBES to enable them, add -DPROBE_HPM to
+   also count hpmcounter3. Without PROBES everything here compiles to
+   nothing. */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+enum {
+  PROBE_MOVE,      // moveSnake
+  PROBE_RENDER,    // render_dirty
+  PROBE_SCORE,     // score_show
+  PROBE_INTERRUPT, // timer_interrupt, switch_interrupt and the buttons
+  PROBE_COUNT
+};
+
+#ifdef PROBES
+
+#include "platform.h"
+
+typedef struct {
+  unsigned int cycles;
+  unsigned int instret;
+#ifdef PROBE_HPM
+  unsigned int hpm;
+#endif
+} ProbeStart;
+
+static inline ProbeStart probe_now(void)
+{
+  ProbeStart now;
+  now.cycles = plat_cycles();
+  now.instret = plat_instret();
+#ifdef PROBE_HPM
+  now.hpm = plat_hpm3();
+#endif
+  return now;
+}
+
+void probe_record(int id, ProbeStart start);
+void probe_reset(void);
+void probe_dump(void);
+
+#define PROBE_BEGIN(id) ProbeStart probe_start_##id = probe_now()
+#define PROBE_END(id) probe_record(id, probe_start_##id)
+
+#else
+
+#define PROBE_BEGIN(id) do {} while (0)
+#define PROBE_END(id) do {} while (0)
+#define probe_reset() do {} while (0)
+#define probe_dump() do {} while (0)
+
+#endif /* PROBES */
+
+#endif /* PROBE_H */
@@ -0,0 +1,231 @@
+/* record.c
+
+   Game recorder and replayer, see record.h for the log format.
+   Recording appends a byte or two per switch change to a fixed buffer,
+   so it is always on. record_dump prints the log over the JTAG UART as
+   lines of "REC " followed by hex bytes, which host/replay.c reads. */
+
+#include "record.h"
+#include "snake.h"
+#include "dtekv-lib.h"
+
+static unsigned char log_buffer[RECORD_MAX_BYTES];
+static int log_bytes;
+static int log_events;
+static unsigned int last_move; // move of the last event, for the deltas
+static int last_switches;
+static bool truncated;
+
+static const unsigned char *replay_log;
+static int replay_bytes;
+static int replay_pos;
+static unsigned int replay_next; // move of the next event
+static int replay_current;
+
+static void put16(unsigned char *p, unsigned int v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static void put32(unsigned char *p, unsigned int v)
+{
+  put16(p, v);
+  put16(p + 2, v >> 16);
+}
+
+static unsigned int get16(const unsigned char *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static unsigned int get32(const unsigned char *p)
+{
+  return get16(p) | (get16(p + 2) << 16);
+}
+
+/**
+ * @arg random_state, see random_get_state
+ * @arg switches, the switches the game starts with
+ * Starts a new log, called when a game starts
+ */
+void record_begin(unsigned int random_state, int switches)
+{
+  log_buffer[0] = 'S';
+  log_buffer[1] = 'R';
+  log_buffer[2] = 1;
+  put16(log_buffer + 3, BOARD_SIZE);
+  put32(log_buffer + 5, random_state);
+  put16(log_buffer + 9, switches);
+  log_bytes = RECORD_HEADER_BYTES;
+  log_events = 0;
+  last_move = 0;
+  last_switches = switches & 3;
+  truncated = false;
+}
+
+/**
+ * @arg move, how many moves have been made when the switches changed
+ * @arg switches, the new value of the switches
+ * Adds an event if the direction switches changed
+ */
+void record_switches(unsigned int move, int switches)
+{
+  switches &= 3;
+  if (switches == last_switches || truncated) {
+    return;
+  }
+  unsigned int value = ((move - last_move) << 2) | switches;
+  unsigned char bytes[5];
+  int n = 0;
+  do {
+    bytes[n] = value & 0x7F;
+    value >>= 7;
+    if (value != 0) {
+      bytes[n] |= 0x80; // more bytes follow
+    }
+    n++;
+  } while (value != 0);
+  if (log_bytes + n > RECORD_MAX_BYTES) {
+    truncated = true;
+    return;
+  }
+  for (int i = 0; i < n; i++) {
+    log_buffer[log_bytes++] = bytes[i];
+  }
+  log_events++;
+  last_move = move;
+  last_switches = switches;
+}
+
+/**
+ * @arg moves, how many moves the game lasted
+ * @arg length, the length of the snake at the end
+ * @arg log, set to the finished log
+ * Finishes the header of the log, called when a game ends
+ * @return the size of the log in bytes
+ */
+int record_end(unsigned int moves, int length, const unsigned char **log)
+{
+  put16(log_buffer + 11, log_events);
+  put32(log_buffer + 13, moves);
+  put16(log_buffer + 17, length);
+  log_buffer[19] = truncated;
+  *log = log_buffer;
+  return log_bytes;
+}
+
+/**
+ * Prints the last finished log over the JTAG UART, waiting for the
+ * UART when the output queue fills up
+ */
+void record_dump(void)
+{
+  static const char hex[] = "0123456789abcdef";
+  for (int i = 0; i < log_bytes; i++) {
+    if (i % 32 == 0) {
+      print("REC ");
+    }
+    printc(hex[log_buffer[i] >> 4]);
+    printc(hex[log_buffer[i] & 0xF]);
+    if (i % 32 == 31 || i == log_bytes - 1) {
+      printc('\n');
+      print_flush();
+    }
+  }
+}
+
+/**
+ * @arg log, a log made by record_end
+ * @arg bytes, its size
+ * Sets the random generator to where the recorded game started, the
+ * next game then replays the log instead of reading the switches
+ * @return false if it is not a log for this build
+ */
+bool replay_load(const unsigned char *log, int bytes)
+{
+  if (bytes < RECORD_HEADER_BYTES || log[0] != 'S' || log[1] != 'R' || log[2] != 1
+      || get16(log + 3) != BOARD_SIZE) {
+    return false;
+  }
+  replay_log = log;
+  replay_bytes = bytes;
+  replay_pos = RECORD_HEADER_BYTES;
+  replay_next = 0;
+  replay_current = get16(log + 9) & 3;
+  random_set_state(get32(log + 5));
+  return true;
+}
+
+/**
+ * @return true while a loaded log has not been played to the end
+ */
+bool replay_active(void)
+{
+  return replay_log != 0;
+}
+
+/**
+ * @return the switches the recorded game started with
+ */
+int replay_initial_switches(void)
+{
+  return get16(replay_log + 9);
+}
+
+/* Reads the next event, leaving replay_next at the move it happens */
+static bool read_event(unsigned int *value)
+{
+  unsigned int v = 0;
+  int shift = 0;
+  while (replay_pos < replay_bytes) {
+    unsigned char b = replay_log[replay_pos++];
+    v |= (unsigned int) (b & 0x7F) << shift;
+    shift += 7;
+    if (!(b & 0x80)) {
+      *value = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @arg move, how many moves have been made
+ * @return the switches as they were recorded at that move, only the
+ * direction switches are replayed
+ */
+int replay_switches(unsigned int move)
+{
+  for (;;) {
+    int pos = replay_pos;
+    unsigned int value;
+    if (!read_event(&value) || replay_next + (value >> 2) > move) {
+      replay_pos = pos; // not yet, read it again next time
+      return replay_current;
+    }
+    replay_next += value >> 2;
+    replay_current = value & 3;
+  }
+}
+
+/**
+ * @arg moves, how many moves the replayed game lasted
+ * @arg length, the length of the snake at the end
+ * Ends the replay
+ * @return REPLAY_MATCHES if the game ended like the recorded one did,
+ * REPLAY_DIFFERS if not, or REPLAY_TRUNCATED if the log lost the events
+ * at the end, so the replay ran out of inputs and could not be compared
+ */
+int replay_finish(unsigned int moves, int length)
+{
+  int result;
+  if (replay_log[19])
+    result = REPLAY_TRUNCATED;
+  else if (get32(replay_log + 13) == moves && (int) get16(replay_log + 17) == length)
+    result = REPLAY_MATCHES;
+  else
+    result = REPLAY_DIFFERS;
+  replay_log = 0;
+  return result;
+}
@@ -0,0 +1,46 @@
+/* record.h
+
+   Record and replay of games. A game only depends on the state of the
+   random generator when it starts, the switches it starts with and the
+   moves at which the switches change, so that is all the log holds.
+
+   Log format, little endian:
+     0  'S' 'R'         magic
+     2  1               version
+     3  u16             BOARD_SIZE
+     5  u32             random_value state at the start of the game
+     9  u16             switches at the start
+     11 u16             number of events
+     13 u32             moves played
+     17 u16             final length of the snake
+     19 u8              1 if the log ran out of room
+     20 events          varint of (moves since the last event << 2 | switches & 3)
+
+   Only the two direction switches are kept, the speed switch does not
+   change what happens in a game, only when. */
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdbool.h>
+
+#define RECORD_HEADER_BYTES 20
+#define RECORD_MAX_BYTES 2048
+
+// How a replayed game ended, see replay_finish
+#define REPLAY_MATCHES 0   // like the recorded one
+#define REPLAY_DIFFERS 1
+#define REPLAY_TRUNCATED 2 // the log ran out of room, so the end was not compared
+
+void record_begin(unsigned int random_state, int switches);
+void record_switches(unsigned int move, int switches);
+int record_end(unsigned int moves, int length, const unsigned char **log);
+void record_dump(void);
+
+bool replay_load(const unsigned char *log, int bytes);
+bool replay_active(void);
+int replay_initial_switches(void);
+int replay_switches(unsigned int move);
+int replay_finish(unsigned int moves, int length);
+
+#endif /* RECORD_H */
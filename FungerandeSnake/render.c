@@ -0,0 +1,372 @@
+/* render.c
+
+   Drawing of the board on the VGA output, moved out of labmain.c.
+
+   The screen shows a VIEW_SIZE x VIEW_SIZE window of the world whose
+   top left cell is the camera. The camera follows the head of the snake
+   and keeps it CAMERA_MARGIN cells away from the edges of the view.
+   When it moves, the part of the picture that is still visible is
+   copied over from the page on screen, shifted by the camera move, and
+   only the newly exposed cells are drawn, so the cost of a frame does
+   not depend on the size of the world.
+
+   Between two moves the head of the player can slide into its new cell
+   and the tail out of the old one (see render_animate_move). Each frame
+   only draws the strip of the two cells that was covered or uncovered
+   since the page was last drawn, a few rows or four columns of a cell.
+
+   Written by Adam Carlström and Arvid Wilhelmsson */
+
+#include "render.h"
+#include "vga.h"
+#include "hud.h"
+#include "sched.h"
+
+#define CELL_WIDTH (SCREEN_WIDTH / VIEW_SIZE)
+#define CELL_HEIGHT ((SCREEN_HEIGHT - HUD_HEIGHT) / VIEW_SIZE) // the HUD is below the board
+
+#define CAMERA_MARGIN 4
+
+Position camera = {0, 0};   // world cell in the top left corner of the view
+Position page_camera[2];    // camera each page was last drawn with
+
+// Cells that changed since each VGA page was last drawn, filled by the game
+// logic and consumed by render_dirty so only those cells are redrawn.
+// There is one list per page since the two pages are drawn every other frame
+#define MAX_DIRTY_CELLS 32 // a few per snake and move, see arena.h
+Position dirty_cells[2][MAX_DIRTY_CELLS];
+int dirty_count[2] = {0, 0};
+bool dirty_overflow[2] = {true, true}; // redraw the whole page instead
+
+// Body and head color of each snake by its id on the board (see arena.h),
+// the first is the single player snake
+#define SNAKE_COLORS 4
+static const int snake_colors[SNAKE_COLORS][2] = {
+    {0x654321, 0x123456}, // white and blue-ish
+    {0x1C, 0x10},         // green
+    {0xE0, 0x80},         // red
+    {0xFC, 0x90},         // yellow
+};
+
+/**
+* @author Arvid Wilhelmsson
+* @arg row, the row in the view where something should be drawn
+* @arg col, the column in the view where something should be drawn
+* @arg color, the color something should be drawn in
+* Function is used to draw rectangles on certain coordinates for the board via the VGA
+* Additionally it draws a border around each cell
+ */
+void draw_cell(int row, int col, int color) {
+    int border_color = 0xFFFFFF;  // Black or any other color
+    vga_fill_cell(col * CELL_WIDTH, row * CELL_HEIGHT, CELL_WIDTH, CELL_HEIGHT, color, border_color);
+}
+ /**
+  * @author Arvid Wilhelmsson
+  * @arg board, the board containing information about where the snake and food is
+  * @arg *snake, the snakes, indexed by the owner ids on the board (see arena.h)
+  * @arg row, the row of the cell in the world
+  * @arg col, the column of the cell in the world
+  * @return the color the VGA should draw for this cell
+  * This function is used to check what is on a part of the board
+  * to determine what color the VGA should draw on this space
+  */
+int cell_color(Board *board, Snake *snake, int row, int col) {
+    int color = 0; // Default color (e.g., empty cell)
+    if (board_is_snake(board, row, col)) {// meaning a snake part is here
+      int owner = board_owner(board, row, col);
+      Snake *s = &snake[owner];
+      //overly complex if-state to check if this part of the snake is the head
+      if(s->head.row == row && s->head.col == col){
+        color = snake_colors[owner % SNAKE_COLORS][1];
+      }else{
+        color = snake_colors[owner % SNAKE_COLORS][0];
+      }
+    } else if (board_is_fruit(board, row, col)) { // meaning a fruit is here
+        color = 0x2B2DCC; // Fruit color (Orange-ish)
+    }
+    return color;
+}
+
+/**
+ * @arg board, the board containing information about where the snake and food is
+ * @arg *snake, contains information about the snake (see snake struct)
+ * @arg row, the row of the cell in the world
+ * @arg col, the column of the cell in the world
+ * Draws one cell of the world if it is inside the view
+ */
+static void draw_world_cell(Board *board, Snake *snake, int row, int col) {
+    int view_row = row - camera.row;
+    int view_col = col - camera.col;
+    if ((unsigned) view_row < VIEW_SIZE && (unsigned) view_col < VIEW_SIZE) {
+      draw_cell(view_row, view_col, cell_color(board, snake, row, col));
+    }
+}
+
+/**
+ * @arg first_row, first_col, the first view cell
+ * @arg rows, cols, how many view cells
+ * Draws a rectangle of view cells from the world
+ */
+static void draw_view_area(Board *board, Snake *snake, int first_row, int first_col, int rows, int cols) {
+    for (int row = first_row; row < first_row + rows; row++) {
+        for (int col = first_col; col < first_col + cols; col++) {
+            draw_cell(row, col, cell_color(board, snake, camera.row + row, camera.col + col));
+        }
+    }
+}
+
+ /**
+  * @author Arvid Wilhelmsson
+  * @arg board, the board containing information about where the snake and food is
+  * @arg *snake, contains information about the snake (see snake struct)
+  * Full redraw of every cell in the view into the page being drawn.
+  * During the game render_dirty is used instead
+  */
+void render_board(Board *board, Snake *snake) {
+    draw_view_area(board, snake, 0, 0, VIEW_SIZE, VIEW_SIZE);
+}
+
+/**
+ * @arg camera, the current camera coordinate
+ * @arg head, the coordinate of the head
+ * @return the camera coordinate that keeps head inside the margins
+ */
+static int follow(int camera, int head) {
+    if (head < camera + CAMERA_MARGIN) {
+      camera = head - CAMERA_MARGIN;
+    } else if (head > camera + VIEW_SIZE - 1 - CAMERA_MARGIN) {
+      camera = head - (VIEW_SIZE - 1 - CAMERA_MARGIN);
+    }
+    if (camera > BOARD_SIZE - VIEW_SIZE) {
+      camera = BOARD_SIZE - VIEW_SIZE;
+    }
+    if (camera < 0) {
+      camera = 0;
+    }
+    return camera;
+}
+
+/**
+ * @arg board, the board containing information about where the snake and food is
+ * @arg *snake, contains information about the snake (see snake struct)
+ * @arg page, the page being drawn
+ * Brings the page to the current camera by copying what is still visible
+ * from the page on screen and drawing only the strips that came into view.
+ * @return false if the camera moved too far and the page needs a full redraw
+ */
+static bool scroll_page(Board *board, Snake *snake, int page) {
+    Position shown = page_camera[1 - page];
+    int dy = camera.row - shown.row;
+    int dx = camera.col - shown.col;
+    if (dy <= -VIEW_SIZE || dy >= VIEW_SIZE || dx <= -VIEW_SIZE || dx >= VIEW_SIZE) {
+      return false;
+    }
+
+    // view cells [dst, dst + keep) come from [dst + d, dst + d + keep) on screen
+    int keep_rows = VIEW_SIZE - (dy < 0 ? -dy : dy);
+    int keep_cols = VIEW_SIZE - (dx < 0 ? -dx : dx);
+    int dst_row = dy < 0 ? -dy : 0;
+    int dst_col = dx < 0 ? -dx : 0;
+    vga_copy_from_front((dst_col + dx) * CELL_WIDTH, (dst_row + dy) * CELL_HEIGHT,
+                        dst_col * CELL_WIDTH, dst_row * CELL_HEIGHT,
+                        keep_cols * CELL_WIDTH, keep_rows * CELL_HEIGHT);
+
+    // the rows and columns that were not on screen before
+    int new_row = dy < 0 ? 0 : keep_rows;
+    int new_col = dx < 0 ? 0 : keep_cols;
+    draw_view_area(board, snake, new_row, 0, VIEW_SIZE - keep_rows, VIEW_SIZE);
+    draw_view_area(board, snake, dst_row, new_col, keep_rows, VIEW_SIZE - keep_cols);
+    return true;
+}
+
+/**
+ * Make the next frame on both pages a full redraw, used when a game starts
+ */
+void invalidate_board(void) {
+    for (int page = 0; page < 2; page++) {
+      dirty_count[page] = 0;
+      dirty_overflow[page] = true;
+    }
+}
+
+/**
+ * @arg row, the row of the cell that changed
+ * @arg col, the column of the cell that changed
+ * Remember that a cell has to be redrawn on the next frame
+ */
+void mark_dirty(int row, int col) {
+    for (int page = 0; page < 2; page++) {
+      if (dirty_count[page] < MAX_DIRTY_CELLS) {
+        dirty_cells[page][dirty_count[page]] = (Position){row, col};
+        dirty_count[page]++;
+      } else {
+        dirty_overflow[page] = true;
+      }
+    }
+}
+
+// The move being animated, see render_animate_move
+#define ANIM_ONE 256
+static bool animating;
+static unsigned int anim_step;    // counts moves, to know when a page is behind
+static Position anim_head;        // the new head, filled from the side it came from
+static Position anim_tail;        // the cell the tail left, emptied towards the new tail
+static int anim_head_direction;   // 0 = north, 1 = east, 2 = south, 3 = west
+static int anim_tail_direction;
+static bool anim_tail_moved;      // false when the snake grew
+static int anim_progress;         // 0 to ANIM_ONE
+static unsigned int page_step[2]; // move each page has started the strips of
+static int page_head_px[2];       // how far the strips are drawn on each page
+static int page_tail_px[2];
+
+/**
+ * @arg cell, a cell of the world
+ * @arg direction, the way the strip grows across the cell
+ * @arg from, to, pixels from the edge it grows from
+ * @arg color, the color of the strip
+ * Fills part of a cell. Strips that grow sideways are whole words wide,
+ * so from and to are multiples of 4 there
+ */
+static void fill_strip(Position cell, int direction, int from, int to, int color) {
+    int view_row = cell.row - camera.row;
+    int view_col = cell.col - camera.col;
+    if ((unsigned) view_row >= VIEW_SIZE || (unsigned) view_col >= VIEW_SIZE || to <= from) {
+      return;
+    }
+    int x = view_col * CELL_WIDTH;
+    int y = view_row * CELL_HEIGHT;
+    switch (direction) {
+      case 0: vga_fill_rect(x, y + CELL_HEIGHT - to, CELL_WIDTH, to - from, color); break;
+      case 1: vga_fill_rect(x + from, y, to - from, CELL_HEIGHT, color); break;
+      case 2: vga_fill_rect(x, y + from, CELL_WIDTH, to - from, color); break;
+      default: vga_fill_rect(x + CELL_WIDTH - to, y, to - from, CELL_HEIGHT, color); break;
+    }
+}
+
+/* Pixels of a cell covered at the current progress, whole words sideways */
+static int strip_pixels(int direction) {
+    if (direction & 1) {
+      return (anim_progress * CELL_WIDTH / ANIM_ONE) & ~3;
+    }
+    return anim_progress * CELL_HEIGHT / ANIM_ONE;
+}
+
+static void draw_world_cell_color(Position cell, int color) {
+    int view_row = cell.row - camera.row;
+    int view_col = cell.col - camera.col;
+    if ((unsigned) view_row < VIEW_SIZE && (unsigned) view_col < VIEW_SIZE) {
+      draw_cell(view_row, view_col, color);
+    }
+}
+
+/**
+ * @arg page, the page being drawn
+ * @arg redrawn, true if cells of the page were drawn again from the board
+ * Brings the strips of the page up to the current progress. A page that
+ * has not started this move yet starts with the head cell empty and the
+ * old tail cell still full
+ */
+static void animate_page(int page, bool redrawn) {
+    if (redrawn || page_step[page] != anim_step) {
+      draw_world_cell_color(anim_head, 0);
+      if (anim_tail_moved) {
+        draw_world_cell_color(anim_tail, snake_colors[0][0]);
+      }
+      page_step[page] = anim_step;
+      page_head_px[page] = 0;
+      page_tail_px[page] = 0;
+    }
+    int head_px = strip_pixels(anim_head_direction);
+    fill_strip(anim_head, anim_head_direction, page_head_px[page], head_px, snake_colors[0][1]);
+    page_head_px[page] = head_px;
+    if (anim_tail_moved) {
+      int tail_px = strip_pixels(anim_tail_direction);
+      fill_strip(anim_tail, anim_tail_direction, page_tail_px[page], tail_px, 0);
+      page_tail_px[page] = tail_px;
+    }
+}
+
+/**
+ * @arg snake, the player, right after moveSnake
+ * @arg old_tail, where its tail was before the move, the same cell if it grew
+ * Starts sliding the head into its new cell and the tail out of the
+ * old one, render_animate_progress says how far they have come
+ */
+void render_animate_move(Snake *snake, Position old_tail) {
+    render_animate_stop(); // the cells of the last move are drawn whole again
+    anim_head = snake->head;
+    anim_head_direction = snake_head_direction(snake);
+    anim_tail = old_tail;
+    anim_tail_direction = position_direction(old_tail, snake->tail);
+    anim_tail_moved = !position_same(old_tail, snake->tail);
+    anim_progress = 0;
+    anim_step++;
+    animating = true;
+}
+
+/**
+ * @arg progress, how far the move has come, 0 to SCHED_PROGRESS_ONE
+ */
+void render_animate_progress(unsigned int progress) {
+    anim_progress = progress >= SCHED_PROGRESS_ONE ? ANIM_ONE : progress * ANIM_ONE / SCHED_PROGRESS_ONE;
+}
+
+/**
+ * Stops the animation, the cells it drew in part are drawn from the
+ * board again on the next frame of each page
+ */
+void render_animate_stop(void) {
+    if (animating) {
+      mark_dirty(anim_head.row, anim_head.col);
+      mark_dirty(anim_tail.row, anim_tail.col);
+      animating = false;
+    }
+}
+
+/**
+ * @arg board, the board containing information about where the snake and food is
+ * @arg *snake, the snakes, indexed by the owner ids on the board, the view follows the first
+ * Draws the next frame into the VGA back buffer, redrawing only the cells
+ * marked by mark_dirty since this page was last drawn, after scrolling
+ * the page if the camera moved.
+ * A move changes at most the new head, old head, old tail and a fruit
+ * so this is a handful of cells instead of the whole board.
+ * Must only be called when no swap is pending (see vga_swap_pending)
+ */
+void render_dirty(Board *board, Snake *snake) {
+    int page = vga_begin_frame();
+    Position head = snake->head;
+    camera.row = follow(camera.row, head.row);
+    camera.col = follow(camera.col, head.col);
+
+    bool moved = page_camera[page].row != camera.row || page_camera[page].col != camera.col;
+    // redrawn cells, or a scroll which copies the strips of the other page,
+    // mean the animated cells have to start over on this page
+    bool redrawn = dirty_overflow[page] || moved || dirty_count[page] > 0;
+    if (dirty_overflow[page] || (moved && !scroll_page(board, snake, page))) {
+      render_board(board, snake);
+    } else {
+      // after a scroll the page matches the one on screen, whose changes
+      // since then are a subset of this page's list, so the list still covers it
+      for (int i = 0; i < dirty_count[page]; i++) {
+        draw_world_cell(board, snake, dirty_cells[page][i].row, dirty_cells[page][i].col);
+      }
+    }
+    if (animating) {
+      animate_page(page, redrawn);
+    }
+    page_camera[page] = camera;
+    dirty_count[page] = 0;
+    dirty_overflow[page] = false;
+    hud_render(page);
+}
+ /**
+  * @author Arvid Wilhelmsson
+  * @arg color, the color something should be drawn
+  * Makes every pixel of the page being drawn the same color, with one
+  * word-wide fill through vga_clear. The game redraws the board with
+  * render_board instead, so this is only for starting from a blank page
+  */
+void clear_screen(int color) {
+    vga_clear(color);
+}
@@ -0,0 +1,29 @@
+/* render.h
+
+   Drawing of the board on the VGA output */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "snake.h"
+
+// Cells shown on the screen in each direction. When the world
+// (BOARD_SIZE) is larger the view follows the head of the snake
+#define VIEW_SIZE 16
+
+#if BOARD_SIZE < VIEW_SIZE
+#error "BOARD_SIZE must be at least VIEW_SIZE"
+#endif
+
+void draw_cell(int row, int col, int color);
+int cell_color(Board *board, Snake *snake, int row, int col);
+void render_board(Board *board, Snake *snake);
+void invalidate_board(void);
+void mark_dirty(int row, int col);
+void render_dirty(Board *board, Snake *snake);
+void render_animate_move(Snake *snake, Position old_tail);
+void render_animate_progress(unsigned int progress);
+void render_animate_stop(void);
+void clear_screen(int color);
+
+#endif /* RENDER_H */
@@ -0,0 +1,350 @@
+/* sched.c
+
+   Software timers on top of the hardware timer.
+
+   Time is kept in microseconds. Every timer interrupt fires the timers
+   whose deadline has passed and programs the timer period to the time
+   left until the earliest next deadline, so there is one interrupt per
+   deadline and no interrupts in between. The cycles between the
+   timeout and the reprogramming are read from the timer snapshot and
+   taken off the new period, so the latency of the interrupt does not
+   add up. The same snapshot gives the time between two timeouts, which
+   makes sched_now_us a clock without a tick of its own.
+
+   The wheel is a small table of timers, looked through at every
+   timeout. With a handful of timers that costs less than keeping them
+   sorted, and a deadline is hit to the cycle instead of to a slot. */
+
+#include "sched.h"
+#include "platform.h"
+
+#define CYCLES_PER_US (TIMER_CLOCK_HZ / 1000000)
+
+// Longest time between two timeouts, so the clock keeps going with no
+// timers at all (the period register fits 143 seconds)
+#define SCHED_IDLE_US 1000000
+
+// Difficulty curve, see sched_move_interval
+#define MOVE_SLOWEST_US 500000 // the original speed
+#define MOVE_FASTEST_US 80000
+#define MOVE_HALF_LENGTH 32    // this many segments more and the interval is halved
+#define START_LENGTH 3
+
+typedef struct {
+  bool active;
+  unsigned int deadline;  // in the time of now_us
+  unsigned int period;    // 0 for a timer that fires once
+  unsigned int last;      // when it last fired
+  unsigned int events;    // SCHED_* bits it posts
+  SchedCallback callback; // run in the interrupt, or 0
+} SchedTimer;
+
+static SchedTimer wheel[SCHED_TIMERS];
+
+static volatile unsigned int due; // SCHED_* bits not yet taken by the game loop
+
+static unsigned int now_us;        // time of the last timeout
+static unsigned int period_us;     // time from the last timeout to the next
+static unsigned int period_cycles; // the timer counts this many from its start to the timeout
+static unsigned int start_cycles;  // cycles from the last timeout to the start of the timer
+static unsigned int carry_cycles;  // of the next timeout past period_us
+static bool firing;                // in sched_timer_interrupt
+
+/* true if deadline is at or before time, also across the 32-bit wrap */
+static inline bool reached(unsigned int time, unsigned int deadline)
+{
+  return (int) (time - deadline) >= 0;
+}
+
+/**
+ * @arg us, time from now_us to the next timeout
+ * @arg late_cycles, cycles that already passed since now_us
+ */
+static void program(unsigned int us, unsigned int late_cycles)
+{
+  unsigned int cycles = us * CYCLES_PER_US;
+  if (cycles > late_cycles + CYCLES_PER_US)
+    cycles -= late_cycles;
+  period_cycles = cycles;
+  start_cycles = late_cycles;
+  // too late to take it off the period, the timeout moves by the rest
+  period_us = (late_cycles + cycles) / CYCLES_PER_US;
+  carry_cycles = late_cycles + cycles - period_us * CYCLES_PER_US;
+  plat_timer_start(cycles - 1); // the counter runs from the period down to 0
+}
+
+/**
+ * @return cycles since now_us, with interrupts masked. A timeout the
+ * interrupt has not handled yet is counted as well
+ */
+static unsigned int elapsed_cycles(void)
+{
+  for (;;) {
+    bool timed_out = plat_timer_timed_out();
+    unsigned int counted = period_cycles - 1 - plat_timer_remaining();
+    if (plat_timer_timed_out() != timed_out)
+      continue; // timed out between the reads, the count could be from either side
+    return timed_out ? start_cycles + period_cycles + counted : start_cycles + counted;
+  }
+}
+
+/* Time from now_us to the earliest deadline */
+static unsigned int next_deadline(void)
+{
+  unsigned int next = SCHED_IDLE_US;
+  for (int i = 0; i < SCHED_TIMERS; i++) {
+    int left = (int) (wheel[i].deadline - now_us);
+    if (!wheel[i].active)
+      continue;
+    if (left <= 0)
+      return 1; // already passed, as soon as possible
+    if ((unsigned int) left < next)
+      next = left;
+  }
+  return next;
+}
+
+/**
+ * Programs the timer again after a timer was added, if the new deadline
+ * comes before the timeout the timer was started for. With interrupts
+ * masked
+ * @arg deadline, of the new timer
+ */
+static void rearm(unsigned int deadline)
+{
+  if (firing || plat_timer_timed_out())
+    return; // the interrupt is running or on its way, and looks at every deadline
+  if (!reached(deadline, now_us + period_us)) {
+    unsigned int elapsed = elapsed_cycles();
+    unsigned int us = elapsed / CYCLES_PER_US;
+    now_us += us; // the clock goes on from here
+    program(next_deadline(), elapsed - us * CYCLES_PER_US);
+  }
+}
+
+/**
+ * @return a timer that is not in use, 0 if all are
+ */
+static SchedTimer *free_timer(void)
+{
+  for (int i = 0; i < SCHED_TIMERS; i++) {
+    if (!wheel[i].active)
+      return &wheel[i];
+  }
+  return 0;
+}
+
+/**
+ * @arg deadline, in the time of sched_now_us
+ * Adds a timer, with interrupts masked
+ * @return false if the wheel is full
+ */
+static bool add(unsigned int deadline, unsigned int period, unsigned int events, SchedCallback callback)
+{
+  SchedTimer *timer = free_timer();
+  if (!timer)
+    return false;
+  timer->deadline = deadline;
+  timer->period = period;
+  timer->last = deadline - period;
+  timer->events = events;
+  timer->callback = callback;
+  timer->active = true;
+  rearm(deadline);
+  return true;
+}
+
+/**
+ * Starts the timer and the clock with no timers in the wheel. Called
+ * once, the clock keeps counting from here
+ */
+void sched_init(void)
+{
+  unsigned int irq = plat_irq_save();
+  for (int i = 0; i < SCHED_TIMERS; i++)
+    wheel[i].active = false;
+  now_us = 0;
+  due = 0;
+  program(next_deadline(), 0);
+  plat_irq_restore(irq);
+}
+
+/**
+ * @return microseconds since sched_init, wrapping after 71 minutes.
+ * Never goes back, as long as interrupts are not masked for longer
+ * than the time between two timeouts
+ */
+unsigned int sched_now_us(void)
+{
+  unsigned int irq = plat_irq_save();
+  unsigned int us = now_us + elapsed_cycles() / CYCLES_PER_US;
+  plat_irq_restore(irq);
+  return us;
+}
+
+/**
+ * @arg events, SCHED_* bits to post every period
+ * @arg period_us, microseconds between them, the first is one period from now
+ * Starts the timer of these events, or starts it over with the new
+ * period. Events of it that the game loop has not taken are dropped
+ */
+void sched_every(unsigned int events, unsigned int period_us)
+{
+  unsigned int irq = plat_irq_save();
+  sched_stop(events);
+  add(sched_now_us() + period_us, period_us, events, 0);
+  plat_irq_restore(irq);
+}
+
+/**
+ * @arg events, SCHED_* bits whose timers stop, their pending events are dropped
+ */
+void sched_stop(unsigned int events)
+{
+  unsigned int irq = plat_irq_save();
+  for (int i = 0; i < SCHED_TIMERS; i++) {
+    if (wheel[i].active && (wheel[i].events & events))
+      wheel[i].active = false;
+  }
+  due &= ~events;
+  plat_irq_restore(irq);
+}
+
+/**
+ * @arg delay_us, microseconds from now
+ * @arg callback, run once in the timer interrupt, or 0 to only wake up
+ * from a wfi then
+ * @return false if the wheel is full and the callback will not run
+ */
+bool sched_after(unsigned int delay_us, SchedCallback callback)
+{
+  unsigned int irq = plat_irq_save();
+  bool added = add(sched_now_us() + delay_us, 0, 0, callback);
+  plat_irq_restore(irq);
+  return added;
+}
+
+/**
+ * @arg us, microseconds to wait
+ * Sleeps in wfi until then, other interrupts are handled as usual
+ */
+void sleep_us(unsigned int us)
+{
+  unsigned int irq = plat_irq_save();
+  unsigned int deadline = sched_now_us() + us;
+  bool woken = us > 0 && add(deadline, 0, 0, 0); // the timeout that ends the sleep
+  while (!reached(sched_now_us(), deadline)) {
+    if (woken)
+      plat_wait_for_interrupt(); // masked, so the interrupt runs below
+    plat_irq_restore(irq);
+    irq = plat_irq_save();
+  }
+  plat_irq_restore(irq);
+}
+
+/**
+ * @arg move_interval_us, microseconds between snake moves
+ * Used from the move after the one already scheduled
+ */
+void sched_set_move_interval(unsigned int move_interval_us)
+{
+  unsigned int irq = plat_irq_save();
+  for (int i = 0; i < SCHED_TIMERS; i++) {
+    if (wheel[i].active && (wheel[i].events & SCHED_MOVE))
+      wheel[i].period = move_interval_us;
+  }
+  plat_irq_restore(irq);
+}
+
+/**
+ * @arg length, the length of the snake
+ * @arg speedup, true if the speedup switch is on
+ * @return the move interval in microseconds
+ * The interval shrinks smoothly as the snake grows. It is halved every
+ * MOVE_HALF_LENGTH segments over the starting length, on a straight line
+ * in between, and never gets shorter than MOVE_FASTEST_US. Speedup
+ * doubles the speed like before
+ */
+unsigned int sched_move_interval(int length, bool speedup)
+{
+  int grown = length > START_LENGTH ? length - START_LENGTH : 0;
+  unsigned int us = MOVE_FASTEST_US;
+  if (grown < MOVE_HALF_LENGTH * 8) { // past that the shift is below the fastest anyway
+    unsigned int from = MOVE_SLOWEST_US >> (grown / MOVE_HALF_LENGTH);
+    us = from - from / 2 * (grown % MOVE_HALF_LENGTH) / MOVE_HALF_LENGTH;
+  }
+  if (speedup)
+    us /= 2;
+  return us < MOVE_FASTEST_US ? MOVE_FASTEST_US : us;
+}
+
+/**
+ * Called by handle_interrupt on every timer interrupt (cause 16)
+ */
+void sched_timer_interrupt(void)
+{
+  unsigned int late = carry_cycles + period_cycles - 1 - plat_timer_remaining();
+  now_us += period_us;
+  start_cycles = carry_cycles; // the clock of the callbacks goes on from the new now_us
+
+  firing = true;
+  for (int i = 0; i < SCHED_TIMERS; i++) {
+    SchedTimer *timer = &wheel[i];
+    if (!timer->active || !reached(now_us, timer->deadline))
+      continue;
+    due |= timer->events;
+    timer->last = now_us;
+    if (timer->period) {
+      timer->deadline += timer->period;
+      if (reached(now_us, timer->deadline)) // fell behind, do not try to catch up
+        timer->deadline = now_us + timer->period;
+    } else {
+      timer->active = false;
+    }
+    if (timer->callback)
+      timer->callback(); // may add timers, the deadlines are looked at below
+  }
+  firing = false;
+  program(next_deadline(), late);
+}
+
+/**
+ * @return the SCHED_* events that are due, without taking them
+ */
+unsigned int sched_pending(void)
+{
+  return due;
+}
+
+/**
+ * @return how far time had come from the last move to the next one at
+ * the last timer interrupt, from 0 to SCHED_PROGRESS_ONE. Used to draw
+ * the frames in between two moves
+ */
+unsigned int sched_move_progress(void)
+{
+  unsigned int since = 0, step = 0;
+  unsigned int irq = plat_irq_save();
+  for (int i = 0; i < SCHED_TIMERS; i++) {
+    if (wheel[i].active && (wheel[i].events & SCHED_MOVE)) {
+      since = now_us - wheel[i].last;
+      step = wheel[i].deadline - wheel[i].last;
+    }
+  }
+  plat_irq_restore(irq);
+  if (step == 0 || since >= step)
+    return SCHED_PROGRESS_ONE;
+  return since * SCHED_PROGRESS_ONE / step;
+}
+
+/**
+ * @return the SCHED_* events that are due, which are then cleared
+ */
+unsigned int sched_take(void)
+{
+  unsigned int irq = plat_irq_save();
+  unsigned int events = due;
+  due = 0;
+  plat_irq_restore(irq);
+  return events;
+}
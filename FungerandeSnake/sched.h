@@ -0,0 +1,42 @@
+/* sched.h
+
+   Software timers on top of the one hardware timer. The timer is not
+   a fixed tick: it is reprogrammed to fire exactly at the earliest
+   deadline of the timers in the wheel, and it keeps a microsecond
+   clock in between. A timer either posts SCHED_* events for the game
+   loop or runs a callback in the interrupt, once or every period */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdbool.h>
+
+#define SCHED_MOVE  0x1 // time for the snake to move
+#define SCHED_FRAME 0x2 // time to handle input and draw
+#define SCHED_BLINK 0x4 // what blinks between games
+
+#define SCHED_FRAME_US 20000   // 50 frames per second
+#define SCHED_BLINK_US 1000000 // once a second
+
+#define SCHED_PROGRESS_ONE 256 // sched_move_progress when the next move is due
+
+#ifndef SCHED_TIMERS
+#define SCHED_TIMERS 8 // timers the wheel has room for
+#endif
+
+typedef void (*SchedCallback)(void);
+
+void sched_init(void);
+unsigned int sched_now_us(void);
+void sched_every(unsigned int events, unsigned int period_us);
+void sched_stop(unsigned int events);
+bool sched_after(unsigned int delay_us, SchedCallback callback);
+void sleep_us(unsigned int us);
+void sched_set_move_interval(unsigned int move_us);
+unsigned int sched_move_interval(int length, bool speedup);
+void sched_timer_interrupt(void);
+unsigned int sched_pending(void);
+unsigned int sched_take(void);
+unsigned int sched_move_progress(void);
+
+#endif /* SCHED_H */
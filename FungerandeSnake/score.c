@@ -0,0 +1,106 @@
+/* score.c
+
+   BCD score counter. addHead and removeTail step it together with the
+   length of the snake, and score_show writes it to the displays, where
+   io.c skips the digits that did not change. The high score stays in
+   RAM between games until the board is reset. */
+
+#include "score.h"
+#include "io.h"
+#include "board.h" // GAME_LOCAL
+
+static GAME_LOCAL unsigned int score;      // six BCD digits, lowest digit in bits 0-3
+static GAME_LOCAL unsigned int high_score; // also BCD, which compares like binary
+
+#define SCORE_MAX 0x999999
+
+/**
+ * @arg value, the new score, 0 to 999999
+ * Converts a binary value once, when a game starts
+ */
+void score_set(int value)
+{
+  score = 0;
+  for (int shift = 0; value > 0 && shift < 4 * DISPLAY_COUNT; shift += 4) {
+    score |= (unsigned int) (value % 10) << shift;
+    value /= 10;
+  }
+}
+
+/**
+ * Adds one, carrying over the digits that wrap from 9 to 0
+ */
+void score_increment(void)
+{
+  if (score == SCORE_MAX) {
+    return;
+  }
+  unsigned int digit = 0xF;
+  unsigned int nine = 0x9;
+  while ((score & digit) == nine) {
+    score &= ~digit; // 9 becomes 0, carry on
+    digit <<= 4;
+    nine <<= 4;
+  }
+  score += digit & 0x111111;
+}
+
+/**
+ * Subtracts one, borrowing from the digits that wrap from 0 to 9
+ */
+void score_decrement(void)
+{
+  if (score == 0) {
+    return;
+  }
+  unsigned int digit = 0xF;
+  unsigned int nine = 0x9;
+  while ((score & digit) == 0) {
+    score |= nine; // 0 becomes 9, borrow on
+    digit <<= 4;
+    nine <<= 4;
+  }
+  score -= digit & 0x111111;
+}
+
+/**
+ * @return the score as six BCD digits
+ */
+unsigned int score_bcd(void)
+{
+  return score;
+}
+
+/**
+ * @return the high score as six BCD digits
+ */
+unsigned int score_high_bcd(void)
+{
+  return high_score;
+}
+
+/**
+ * Called when a game ends, keeps the score if it beat the high score
+ * @return true for a new high score
+ */
+bool score_finish(void)
+{
+  if (score > high_score) {
+    high_score = score;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @arg high, shows the high score with the leftmost decimal point lit
+ * instead of the score
+ */
+void score_show(bool high)
+{
+  if (high) {
+    set_displays_bcd(high_score, true);
+  } else {
+    set_displays_bcd(score, false);
+  }
+}
@@ -0,0 +1,19 @@
+/* score.h
+
+   The score (the length of the snake) and the high score, kept as
+   BCD so the 7-segment displays can be updated without dividing */
+
+#ifndef SCORE_H
+#define SCORE_H
+
+#include <stdbool.h>
+
+void score_set(int value);
+void score_increment(void);
+void score_decrement(void);
+unsigned int score_bcd(void);
+unsigned int score_high_bcd(void);
+bool score_finish(void);
+void score_show(bool high);
+
+#endif /* SCORE_H */
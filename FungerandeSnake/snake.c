@@ -0,0 +1,350 @@
+/* snake.c
+
+   The game logic: the snake, the board and the rules,
+   moved out of labmain.c. Nothing in here touches the hardware
+   directly so it builds for the host as well (see platform.h).
+
+   Written by Adam Carlström and Arvid Wilhelmsson */
+
+#include "snake.h"
+#include "freecells.h"
+#include "render.h"
+#include "io.h"
+#include "score.h"
+#include "dtekv-lib.h"
+
+// Seed for the fruit positions, set once by main
+GAME_LOCAL int seed = 0;
+
+// The empty cells of the board, kept in step with it by addHead,
+// removeTail and fruitSpawnRandom
+GAME_LOCAL FreeCells free_cells;
+
+/**
+ * @author Adam Carlström (copied by)
+ * @arg seed, used to determine randomness
+ * @return a (pseudo) random integer value
+ * This code was found in a discussion on the Dtek canvas page created by Albin Sijmer
+ * The code was created by Natan Odin Herman Hyötyläinen and further altered by Fredrik Lundevall
+ */
+static GAME_LOCAL int hasbeencalled = 0; /* flag */
+static GAME_LOCAL unsigned int state;
+
+unsigned int random_value(unsigned int* seed) {
+  if( !hasbeencalled ) {
+    hasbeencalled = 1;
+    state = *seed; /* the pointer seed is only used once */ 
+  }
+  /* actual pseudo-random number generation starts here */
+  state = state * 747796405 + 2891336453;
+  unsigned int result = ((state >> ((state >> 28) + 4)) ^ state) * 277803737;
+  result = (result >> 22) ^ result;
+  return result;
+}
+
+/**
+ * @return the state of random_value, which decides every value it
+ * returns from now on (see record.c)
+ */
+unsigned int random_get_state(void) {
+  return state;
+}
+
+/**
+ * @arg value, a state from random_get_state
+ * Makes random_value continue from an earlier state
+ */
+void random_set_state(unsigned int value) {
+  hasbeencalled = 1;
+  state = value;
+}
+
+/**
+ * @author Adam Carlström
+ * @arg snake, the variable holding the snake struct
+ * @arg startrow, the starting row coordinate for the snake
+ * @arg startcol, the starting column coordinate for the snake
+ * @arg initalLength, the starting length for the snake
+ * This function initializes all the values for the snake struct
+ */
+void initSnake(Snake *snake, int startRow, int startCol, int initialLength) {
+    score_set(initialLength);
+    snake-> snake_playing = true;
+    snake->right = false;
+    snake->left = false;
+    snake->direction = 1; // 0 = north, 1 = east, 2 = south, 3 = west
+    snake->id = 0;
+
+    // Populate the initial snake segments, starting horizontally from left to right
+    snake_lay(snake, (Position){startRow, startCol}, 1, initialLength);
+}
+
+/**
+ * @arg snake, the snake whose body is replaced
+ * @arg tail, the cell of the tail
+ * @arg direction, the way the body goes from the tail to the head
+ * @arg length, segments of the new body, at least 1
+ * Lays the body out in a straight line
+ */
+void snake_lay(Snake *snake, Position tail, int direction, int length) {
+    snake->tail = tail;
+    snake->head = tail;
+    snake->first = 0;
+    snake->length = length;
+    unsigned char steps = direction * 0x55; // the same step in all four places of a byte
+    for (int i = 0; i < length - 1; i += 4) {
+        snake->body[i >> 2] = steps;
+    }
+    for (int i = 1; i < length; i++) {
+        snake->head = position_step(snake->head, direction);
+    }
+}
+
+/**
+ * @author Adam Carlström
+ * @arg Snake, the variable holding the snake struct
+ * This function is called if the snake has died
+ */
+void gameOver(Snake *snake){
+    print("YOU LOST \n");
+    print("Press button to replay \n");
+    snake->snake_playing = false;
+    set_leds(2047);// 2^11-1 = all leds turned on
+}
+
+/**
+ * @author Arvid Wilhelmsson
+ * @arg Snake, the variable holding the snake struct
+ * This function is called if the snake has a total length of 100
+ * meaning it has filled the board and therefore won the game
+ */
+void gameWin(Snake *snake){
+    print("You won \n");
+    snake->snake_playing = false;
+    set_leds(1365);// 2^10 + 2^8 + 2^6 + 2^4 + 2^2 + 2^0 = 1365 = every other led turned on
+}
+
+/**
+ * @author Adam Carlström
+ * @arg Snake, the variable holding the snake struct
+ * @arg newhead, a position/coordinate for the new position of the head,
+ * next to the head it has now
+ * Add a new head position to the snake
+ */
+void addHead(Snake *snake, Position newHead) {
+    Position oldHead = snake->head;
+    mark_dirty(oldHead.row, oldHead.col); // old head is drawn as body now
+    mark_dirty(newHead.row, newHead.col);
+    free_cells_remove(&free_cells, CELL_INDEX(newHead.row, newHead.col));
+    int index = snake->first + snake->length - 1; // after the last step
+    if (index >= SNAKE_RING) {
+        index -= SNAKE_RING;
+    }
+    int shift = (index & 3) * 2;
+    unsigned char *byte = &snake->body[index >> 2];
+    *byte = (*byte & ~(3 << shift)) | position_direction(oldHead, newHead) << shift;
+    snake->head = newHead;
+    snake->length++;
+    if (snake->id == 0) {
+      score_increment();
+    }
+}
+/**
+ * @author Adam Carlström
+ * @arg Snake, the variable holding the snake struct
+ * Remove the tail position of the snake, which is two or more long
+ */
+void removeTail(Snake *snake) {
+    Position tailPos = snake->tail;
+    mark_dirty(tailPos.row, tailPos.col);
+    free_cells_add(&free_cells, CELL_INDEX(tailPos.row, tailPos.col));
+    snake->tail = position_step(tailPos, snake_step(snake, snake->first));
+    snake->first = snake_ring_next(snake->first);
+    snake->length--;
+    if (snake->id == 0) {
+      score_decrement();
+    }
+}
+
+/**
+ * @author Adam Carlström
+ * @arg board, the board used for the game
+ * The function makes sure new fruit spawns in a position that is empty.
+ * The position is drawn from the set of empty cells (see freecells.c)
+ * so it takes the same time however full the board is
+ * @return the cell the fruit was put on, -1 if the board is full
+ */
+int fruitSpawnRandom(Board *board){
+  if(free_cells.count == 0){
+    return -1; // nowhere to put it
+  }
+  unsigned int tmp = (unsigned int)seed;
+  int cell = free_cells_pick(&free_cells, random_value(&tmp)); // always empty, no retries needed
+  int x = cell / BOARD_SIZE;
+  int y = cell % BOARD_SIZE;
+  board_set_fruit(board, x, y);//mat
+  free_cells_remove(&free_cells, cell);
+  mark_dirty(x, y);
+  return cell;
+}
+
+/**
+ * @author Adam Carlström
+ * @arg snake, the variable holding the snake struct
+ * @arg board, the board for this game
+ * The function updates the position of the snake based on 
+ * the direction it wants to go and updates its head and tail
+ * correspondingly. Additionally it checks how this new position
+ * might affect the game by checking collision with itself,
+ * walls, and fruits. Also checks if the snake dies or wins.
+ */
+void moveSnake(Snake *snake, Board *board) {
+    int direction_rows = 0;
+    int direction_columns = 0;
+    switch(snake->direction){
+        case 0://north
+            direction_rows = -1;
+            direction_columns = 0;
+        break;
+        case 1://east
+            direction_rows = 0;
+            direction_columns = 1;
+        break;
+        case 2://south
+            direction_rows = 1;
+            direction_columns = 0;
+        break;
+        case 3://west
+            direction_rows = 0;
+            direction_columns = -1;
+        break;
+        default: // in the case it gets here, reset directions to default
+            snake->direction = 1; //east som default
+            snake->right = false;//rakt fram som default
+            snake->left = false;
+            break;
+    }
+
+    Position newHead = {
+        snake->head.row + direction_rows,
+        snake->head.col + direction_columns
+    };
+
+    // Check collision with walls first, the board has nothing outside of it
+    if(newHead.row >= BOARD_SIZE || newHead.row <= -1 || newHead.col >= BOARD_SIZE || newHead.col <= -1){//outofBounds
+        gameOver(snake);
+        return;
+    }
+
+    if (board_is_empty(board, newHead.row, newHead.col)) {// means snake is moving where nothing else is
+        // Remove the tail if the snake isn't growing
+        Position tailPos = snake->tail;
+        board_clear_snake(board, tailPos.row, tailPos.col); // Clear tail position on board
+        removeTail(snake);
+    }else if(board_is_snake(board, newHead.row, newHead.col)){// means that the snake has moved into itself
+        gameOver(snake);
+    }else{// means that fruit is found here 
+        board_clear_fruit(board, newHead.row, newHead.col); // eaten
+        if(snake->length <= BOARD_SIZE*BOARD_SIZE-FRUIT_COUNT){// only spawn fruit if there is space for it
+          fruitSpawnRandom(board); // spawn new fruit so that there is always FRUIT_COUNT of them
+        }
+    }
+    // Add the new head to the snake
+    if(snake->snake_playing){
+      addHead(snake, newHead);
+      board_place_snake(board, newHead.row, newHead.col, snake->id); // Mark new head position on board
+      if(snake->length >= BOARD_SIZE*BOARD_SIZE){ // check win condition, the snake fills the board
+        gameWin(snake);
+      }
+    }
+}
+
+/**
+ * @author Adam Carlström
+ * @arg right, boolean value to show if the user wants to turn right
+ * @arg left, boolean value to show if the user wants to turn left
+ * @arg currentDirection, holds the integer value for the current direction
+ * @return an int for the direction it should go if it turns right/left from here
+ */
+int calculateDirectionChange(bool right,bool left, int currentDirection){
+  int returnvalue = currentDirection;
+  if(right && !left){
+      returnvalue += 1;
+      if(returnvalue >= 4){//if on west = 3 and wants to go right, go to north = 0
+          return 0;
+      }   
+  }else if(!right && left){
+      returnvalue -= 1;
+      if(returnvalue <= -1){//if on north = 0 and wants to go left, go to west = 3
+          return 3;
+      }
+  }
+  return returnvalue;
+}
+
+/**
+ * @author Adam Carlström
+ * @arg snake, the variable holding the snake struct
+ * @arg right, boolean value to show if the user wants to turn right
+ * @arg left, boolean value to show if the user wants to turn left
+ * Used to change the direction of the snake
+ */
+void changeDirectionSnake(Snake *snake, bool right, bool left){
+    snake->right = right;
+    snake->left = left;
+    if(right && left){
+        //no change = go straight
+    }else{
+      
+      snake->direction = calculateDirectionChange(snake->right,snake->left, snake->direction);
+    }
+}
+
+/**
+ * @author Arvid Wilhelmsson
+ * @arg board, the board of the game
+ * Function to print the board (for debugging)
+ */
+void printBoard(Board *board) {
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            print_dec(board_get(board, i, j));
+            print(" ");
+        }
+        print("\n");
+    }
+    print("free cells: ");
+    print_dec(board_count_free(board));
+    print("\n\n");
+}
+
+/**
+ * @author Adam Carlström
+ * @arg snake, the variable holding the snake struct
+ * @arg board, the board of the game
+ * The function is used to initialize variables to start the game
+ */
+void startgame(Snake *snake, Board *board){
+  //print("Game Started \n");
+  //board[x][y]
+  board_clear(board);
+  int initialLength = 3;
+  initSnake(snake, BOARD_SIZE/2, 1,initialLength);
+  // Mark initial snake positions on the board
+  free_cells_init(&free_cells);
+  for (SnakeIter it = snake_iter(snake); it.left > 0; snake_iter_next(snake, &it)) {
+      Position pos = it.pos;
+      board_place_snake(board, pos.row, pos.col, snake->id);
+      free_cells_remove(&free_cells, CELL_INDEX(pos.row, pos.col));
+  }
+
+  board_set_fruit(board, BOARD_SIZE/2+1, BOARD_SIZE-BOARD_SIZE/4-1);//mat
+  board_set_fruit(board, BOARD_SIZE/2, BOARD_SIZE-BOARD_SIZE/4);//mat
+  board_set_fruit(board, BOARD_SIZE/2-1, BOARD_SIZE-BOARD_SIZE/4-1);//mat
+  free_cells_remove(&free_cells, CELL_INDEX(BOARD_SIZE/2+1, BOARD_SIZE-BOARD_SIZE/4-1));
+  free_cells_remove(&free_cells, CELL_INDEX(BOARD_SIZE/2, BOARD_SIZE-BOARD_SIZE/4));
+  free_cells_remove(&free_cells, CELL_INDEX(BOARD_SIZE/2-1, BOARD_SIZE-BOARD_SIZE/4-1));
+  for (int i = 3; i < FRUIT_COUNT; i++) { // the rest of the fruit in a larger world
+      fruitSpawnRandom(board);
+  }
+}
@@ -0,0 +1,125 @@
+/* snake.h
+
+   The game logic: the snake, the board and the rules */
+
+#ifndef SNAKE_H
+#define SNAKE_H
+
+#include <stdbool.h>
+#include "board.h"
+
+// Fruits on the board at a time, three per 16x16 cells
+#define FRUIT_COUNT (3 * (BOARD_SIZE / 16) * (BOARD_SIZE / 16) > 3 ? 3 * (BOARD_SIZE / 16) * (BOARD_SIZE / 16) : 3)
+
+// Structs used for the snake
+
+// Position struct to hold row and column
+typedef struct {
+    int row;
+    int col;
+} Position;
+
+// Steps the body has room for, as many as the cells of the board. A
+// snake that fills the board has one step less, so the ring is never full
+#define SNAKE_RING (BOARD_SIZE * BOARD_SIZE)
+
+// Queue to hold the snake's body segments. Only the cells of the head
+// and the tail are kept, and in between the direction of every step
+// from the tail to the head, two bits each in a ring. Each segment then
+// takes 2 bits instead of a Position, so the queue stays small on a
+// large board (see BOARD_SIZE) and with many snakes (see arena.h)
+typedef struct {
+    unsigned char body[(SNAKE_RING + 3) / 4]; // 0 = north, 1 = east, 2 = south, 3 = west
+    Position head;
+    Position tail;
+    int first;  // index in body of the step out of the tail
+    int length; // segments, so length - 1 steps
+    bool right;
+    bool left;
+    int direction;
+    bool snake_playing;
+    int id; // owner of its cells on the board, 0 is the player with the score
+} Snake;
+
+// Walks the body from the tail to the head, see snake_iter
+typedef struct {
+    Position pos; // the segment it is at
+    int index;    // in body, of the step to the next one
+    int left;     // segments from this one to the head
+} SnakeIter;
+
+extern GAME_LOCAL int seed;
+
+/* The cell next to pos in direction, 0 = north, 1 = east, 2 = south, 3 = west */
+static inline Position position_step(Position pos, int direction)
+{
+    pos.row += (direction == 2) - (direction == 0);
+    pos.col += (direction == 1) - (direction == 3);
+    return pos;
+}
+
+/* Direction of a step from one cell to the next */
+static inline int position_direction(Position from, Position to)
+{
+    if (to.row < from.row) return 0;
+    if (to.col > from.col) return 1;
+    if (to.row > from.row) return 2;
+    return 3;
+}
+
+static inline bool position_same(Position a, Position b)
+{
+    return a.row == b.row && a.col == b.col;
+}
+
+/* The step at index in the ring of the body */
+static inline int snake_step(const Snake *snake, int index)
+{
+    return (snake->body[index >> 2] >> ((index & 3) * 2)) & 3;
+}
+
+static inline int snake_ring_next(int index)
+{
+    return index + 1 == SNAKE_RING ? 0 : index + 1;
+}
+
+/* Direction of the last step, into the head, for a snake of two or more */
+static inline int snake_head_direction(const Snake *snake)
+{
+    int index = snake->first + snake->length - 2;
+    return snake_step(snake, index >= SNAKE_RING ? index - SNAKE_RING : index);
+}
+
+/* At the tail, for (SnakeIter it = snake_iter(snake); it.left > 0; snake_iter_next(snake, &it)) */
+static inline SnakeIter snake_iter(const Snake *snake)
+{
+    SnakeIter it = {snake->tail, snake->first, snake->length};
+    return it;
+}
+
+/* On to the next segment towards the head */
+static inline void snake_iter_next(const Snake *snake, SnakeIter *it)
+{
+    if (--it->left > 0) {
+        it->pos = position_step(it->pos, snake_step(snake, it->index));
+        it->index = snake_ring_next(it->index);
+    }
+}
+
+unsigned int random_value(unsigned int* seed);
+unsigned int random_get_state(void);
+void random_set_state(unsigned int value);
+void initSnake(Snake *snake, int startRow, int startCol, int initialLength);
+void snake_lay(Snake *snake, Position tail, int direction, int length);
+void gameOver(Snake *snake);
+void gameWin(Snake *snake);
+void addHead(Snake *snake, Position newHead);
+void removeTail(Snake *snake);
+int fruitSpawnRandom(Board *board);
+void moveSnake(Snake *snake, Board *board);
+int calculateDirectionChange(bool right,bool left, int currentDirection);
+void changeDirectionSnake(Snake *snake, bool right, bool left);
+void printBoard(Board *board);
+void startgame(Snake *snake, Board *board);
+
+#endif /* SNAKE_H */
@@ -0,0 +1,264 @@
+/* vga.c
+
+   Framebuffer kernels that store 32-bit words instead of single bytes.
+   x and width must be multiples of 4 so every store is word aligned,
+   which holds for the board cells (CELL_WIDTH is 20) and full rows. */
+
+#include "vga.h"
+#include "platform.h"
+#include "dtekv-lib.h"
+#include "mem.h"
+
+#define WORDS_PER_ROW (SCREEN_WIDTH / 4)
+
+/* Second page in main memory, the first one is VGA_BASE */
+static unsigned int back_page[VGA_FRAME_BYTES / 4];
+
+/* Page the kernels draw into */
+static uintptr_t draw_base;
+
+/* Byte repeated in all four lanes of a word */
+static inline unsigned int splat(int color)
+{
+  return ((unsigned int) color & 0xFF) * 0x01010101u;
+}
+
+static inline volatile unsigned int *row_address(int x, int y)
+{
+  return (volatile unsigned int *) (draw_base + y * SCREEN_WIDTH + x);
+}
+
+/**
+ * Sets up double buffering: VGA_BASE is shown and back_page is drawn into
+ */
+void vga_init(void)
+{
+  plat_vga_set_backbuffer((uintptr_t) back_page);
+  draw_base = (uintptr_t) back_page;
+}
+
+/**
+ * @return nonzero while a swap requested by vga_present has not happened yet.
+ * The back buffer is still on screen until then and must not be drawn into
+ */
+int vga_swap_pending(void)
+{
+  return plat_vga_swap_pending();
+}
+
+/**
+ * Points the kernels at the current back buffer.
+ * Only call this when vga_swap_pending() is false
+ * @return which page is drawn into, 0 for VGA_BASE and 1 for the other one
+ */
+int vga_begin_frame(void)
+{
+  draw_base = plat_vga_backbuffer();
+  return draw_base == VGA_BASE ? 0 : 1;
+}
+
+/**
+ * Asks the controller to show the back buffer from the next vertical sync.
+ * Returns right away, use vga_swap_pending to know when it is done
+ */
+void vga_present(void)
+{
+  plat_vga_swap();
+}
+
+/* Store value into n consecutive words, four words per iteration */
+static inline void fill_words(volatile unsigned int *p, unsigned int value, int n)
+{
+  while (n >= 4) {
+    p[0] = value;
+    p[1] = value;
+    p[2] = value;
+    p[3] = value;
+    p += 4;
+    n -= 4;
+  }
+  while (n > 0) {
+    *p++ = value;
+    n--;
+  }
+}
+
+/**
+ * @arg src_x, src_y, top left pixel of the area on the page being shown
+ * @arg dst_x, dst_y, where it goes on the page being drawn
+ * @arg width, height, size in pixels
+ * All x values and the width must be multiples of 4.
+ * Copies an already drawn area from the front page, which is how the
+ * board scrolls without drawing every cell again
+ */
+void vga_copy_from_front(int src_x, int src_y, int dst_x, int dst_y, int width, int height)
+{
+  volatile unsigned int *src = (volatile unsigned int *) (plat_vga_frontbuffer() + src_y * SCREEN_WIDTH + src_x);
+  volatile unsigned int *dst = row_address(dst_x, dst_y);
+  int words = width >> 2;
+  for (int row = 0; row < height; row++) {
+    int n = words;
+    volatile unsigned int *s = src;
+    volatile unsigned int *d = dst;
+    while (n >= 4) {
+      d[0] = s[0];
+      d[1] = s[1];
+      d[2] = s[2];
+      d[3] = s[3];
+      s += 4;
+      d += 4;
+      n -= 4;
+    }
+    while (n > 0) {
+      *d++ = *s++;
+      n--;
+    }
+    src += WORDS_PER_ROW;
+    dst += WORDS_PER_ROW;
+  }
+}
+
+/**
+ * @arg x, y, the top left pixel (x multiple of 4)
+ * @arg width, height, size in pixels (width multiple of 4)
+ * @arg color, the color of the rectangle
+ * Fills a solid rectangle
+ */
+void vga_fill_rect(int x, int y, int width, int height, int color)
+{
+  unsigned int value = splat(color);
+  int words = width >> 2;
+  volatile unsigned int *p = row_address(x, y);
+  for (int row = 0; row < height; row++) {
+    fill_words(p, value, words);
+    p += WORDS_PER_ROW;
+  }
+}
+
+/**
+ * @arg x, y, the top left pixel (x multiple of 4)
+ * @arg width, height, size in pixels (width multiple of 4)
+ * @arg color, the color inside the cell
+ * @arg border_color, the color of the dotted border
+ * Border pixels sit on the edges of the cell where both x and the row
+ * within the cell are even. Counting rows from the cell and not from the
+ * screen makes every cell look the same wherever it is, so a drawn cell
+ * can be moved by any number of rows when the board scrolls.
+ * With x and width multiples of 4 that leaves three row patterns which
+ * are built once per call: the top/bottom row (every even pixel), a
+ * middle row (only the leftmost pixel) and odd rows (no border at all).
+ */
+void vga_fill_cell(int x, int y, int width, int height, int color, int border_color)
+{
+  unsigned int fill = splat(color);
+  unsigned int border = splat(border_color);
+  unsigned int dotted = (fill & 0xFF00FF00u) | (border & 0x00FF00FFu); // bytes 0 and 2 are even x
+  unsigned int left = (fill & 0xFFFFFF00u) | (border & 0x000000FFu);
+  int words = width >> 2;
+  volatile unsigned int *p = row_address(x, y);
+
+  for (int row = 0; row < height; row++) {
+    if (row & 1) {
+      fill_words(p, fill, words);
+    } else if (row == 0 || row == height - 1) {
+      fill_words(p, dotted, words);
+    } else {
+      p[0] = left;
+      fill_words(p + 1, fill, words - 1);
+    }
+    p += WORDS_PER_ROW;
+  }
+}
+
+/**
+ * @arg x, y, the top left pixel (x multiple of 4)
+ * @arg masks, two words per row, 0xFF in the bytes of foreground pixels
+ * @arg rows, how many rows of 8 pixels to draw
+ * @arg color, background_color, the colors of set and clear pixels
+ * Draws an 8 pixel wide bitmap, two word stores per row
+ */
+void vga_draw_mask(int x, int y, const unsigned int *masks, int rows, int color, int background_color)
+{
+  unsigned int fg = splat(color);
+  unsigned int bg = splat(background_color);
+  volatile unsigned int *p = row_address(x, y);
+  for (int row = 0; row < rows; row++) {
+    p[0] = (fg & masks[0]) | (bg & ~masks[0]);
+    p[1] = (fg & masks[1]) | (bg & ~masks[1]);
+    masks += 2;
+    p += WORDS_PER_ROW;
+  }
+}
+
+/**
+ * @arg color, the color every pixel gets
+ * Clears the whole screen, the rows are contiguous so it is one fill
+ */
+void vga_clear(int color)
+{
+  mem_fill32((void *) row_address(0, 0), splat(color), WORDS_PER_ROW * SCREEN_HEIGHT);
+}
+
+#ifdef VGA_BENCH
+/* The byte-at-a-time loops the kernels replaced, kept for comparison */
+static void draw_cell_bytes(int x, int y, int width, int height, int color, int border_color)
+{
+  volatile char *vga = (volatile char *) draw_base;
+  int end_y = y + height;
+  int end_x = x + width;
+  int space = 2;
+  for (int yy = y; yy < end_y; yy++) {
+    for (int xx = x; xx < end_x; xx++) {
+      if ((yy == y || yy == end_y - 1 || xx == x || xx == end_x - 1) && (yy%space == 0 && xx%space == 0)) {
+        vga[yy * SCREEN_WIDTH + xx] = (char) border_color;
+      } else {
+        vga[yy * SCREEN_WIDTH + xx] = (char) color;
+      }
+    }
+  }
+}
+
+static void clear_bytes(int color)
+{
+  volatile char *vga = (volatile char *) draw_base;
+  for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
+    vga[i] = (char) color;
+  }
+}
+
+static void report(char *name, unsigned int bytes_cycles, unsigned int words_cycles)
+{
+  print(name);
+  print(": bytes ");
+  print_dec(bytes_cycles);
+  print(" cycles, words ");
+  print_dec(words_cycles);
+  print(" cycles\n");
+}
+
+/**
+ * Times one 20x15 cell and one full screen clear with the byte loops
+ * and the word kernels and prints the cycle counts over JTAG.
+ * Built with -DVGA_BENCH
+ */
+void vga_bench(void)
+{
+  unsigned int t0, t1, t2;
+
+  draw_base = VGA_BASE;
+
+  t0 = plat_cycles();
+  draw_cell_bytes(20, 15, 20, 15, 0x21, 0xFF);
+  t1 = plat_cycles();
+  vga_fill_cell(20, 15, 20, 15, 0x21, 0xFF);
+  t2 = plat_cycles();
+  report("cell", t1 - t0, t2 - t1);
+
+  t0 = plat_cycles();
+  clear_bytes(0);
+  t1 = plat_cycles();
+  vga_clear(0);
+  t2 = plat_cycles();
+  report("clear", t1 - t0, t2 - t1);
+}
+#endif
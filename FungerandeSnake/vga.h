@@ -0,0 +1,30 @@
+/* vga.h
+
+   Word-wide framebuffer kernels for the DTEK-V VGA output.
+   The framebuffer is one byte per pixel, SCREEN_WIDTH bytes per row,
+   so anything starting on a multiple of 4 pixels is word aligned.
+
+   Drawing goes to the back buffer of the pixel buffer DMA controller.
+   vga_present requests a swap which the controller performs at the
+   next vertical sync, so a frame is never shown half drawn. */
+
+#ifndef VGA_H
+#define VGA_H
+
+#define SCREEN_WIDTH 320
+#define SCREEN_HEIGHT 240
+#define VGA_FRAME_BYTES (SCREEN_WIDTH * SCREEN_HEIGHT)
+
+void vga_init(void);
+int vga_swap_pending(void);
+int vga_begin_frame(void);
+void vga_present(void);
+
+void vga_copy_from_front(int src_x, int src_y, int dst_x, int dst_y, int width, int height);
+void vga_fill_rect(int x, int y, int width, int height, int color);
+void vga_fill_cell(int x, int y, int width, int height, int color, int border_color);
+void vga_draw_mask(int x, int y, const unsigned int *masks, int rows, int color, int background_color);
+void vga_clear(int color);
+void vga_bench(void);
+
+#endif /* VGA_H */